@@ -0,0 +1,587 @@
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "hash_table.h"
+#include "workloads.h"
+
+#if __has_include(<absl/container/flat_hash_map.h>)
+#include <absl/container/flat_hash_map.h>
+#define NWACC_BENCH_ABSL 1
+#endif
+
+#if __has_include(<ankerl/unordered_dense.h>)
+#include <ankerl/unordered_dense.h>
+#define NWACC_BENCH_ANKERL 1
+#endif
+
+/**
+ * Benchmarks of nwacc::hash_table against std::unordered_map, and against
+ * absl::flat_hash_map and ankerl::unordered_dense when their headers are found.
+ * Every benchmark runs with integer and string keys, from tables that fit in
+ * the L1 cache up to tables that only fit in main memory, at several max load
+ * factors. The workload benchmarks then replay the key distributions of
+ * workloads.h: sequential, clustered, and URL keys, Zipfian lookups, and
+ * mixed read and write ratios. Run with --benchmark_filter to pick a subset,
+ * for example --benchmark_filter=LookupHit/nwacc.
+ */
+namespace {
+
+	typedef std::uint64_t value_type;
+
+	/**
+	 * The table sizes, in entries, from L1 resident to DRAM resident.
+	 */
+	const std::int64_t kSmallest = std::int64_t{ 1 } << 10;
+	const std::int64_t kLargest = std::int64_t{ 1 } << 22;
+
+	/**
+	 * The max load factors, in percent.
+	 */
+	const std::int64_t kLoads[] = { 50, 75, 90 };
+
+	/**
+	 * Build the key for a number, distinct for every number.
+	 */
+	template <typename K>
+	K make_key(std::uint64_t number);
+
+	template <>
+	std::uint64_t make_key<std::uint64_t>(const std::uint64_t number)
+	{
+		return nwacc::mix(number);
+	}
+
+	template <>
+	std::string make_key<std::string>(const std::uint64_t number)
+	{
+		return "key:" + std::to_string(nwacc::mix(number));
+	}
+
+	/**
+	 * The keys of a benchmark, built once per size and kept for the whole run.
+	 * @param count the number of keys.
+	 * @param missing true for keys that are never inserted.
+	 * @return the keys, in a random order.
+	 */
+	template <typename K>
+	const std::vector<K> & keys_for(const std::size_t count, const bool missing)
+	{
+		static std::map<std::pair<std::size_t, bool>, std::vector<K>> cache;
+		auto & keys = cache[{ count, missing }];
+		if (keys.empty())
+		{
+			keys.reserve(count);
+			const std::uint64_t first = missing ? std::uint64_t{ 1 } << 40 : 0;
+			for (std::uint64_t i = 0; i < count; i++)
+			{
+				keys.push_back(make_key<K>(first + i));
+			}
+			std::shuffle(keys.begin(), keys.end(), std::mt19937_64(count));
+		} // else, the keys were built by an earlier benchmark, do_nothing();
+		return keys;
+	}
+
+	/**
+	 * The operations of the benchmarks, for the std::unordered_map interface
+	 * shared by absl and ankerl, and for nwacc::hash_table.
+	 */
+	template <typename Map, typename K>
+	void insert(Map & map, const K & key, const value_type value)
+	{
+		map.emplace(key, value);
+	}
+
+	template <typename K, typename H, typename E, typename P, typename A>
+	void insert(nwacc::hash_table<value_type, K, H, E, P, A> & map, const K & key, const value_type value)
+	{
+		map.insert(value, key);
+	}
+
+	template <typename Map, typename K>
+	bool contains(const Map & map, const K & key)
+	{
+		return map.find(key) != map.end();
+	}
+
+	template <typename K, typename H, typename E, typename P, typename A>
+	bool contains(const nwacc::hash_table<value_type, K, H, E, P, A> & map, const K & key)
+	{
+		return map.contains(key);
+	}
+
+	template <typename Map, typename K>
+	void remove(Map & map, const K & key)
+	{
+		map.erase(key);
+	}
+
+	template <typename K, typename H, typename E, typename P, typename A>
+	void remove(nwacc::hash_table<value_type, K, H, E, P, A> & map, const K & key)
+	{
+		map.remove(key);
+	}
+
+	template <typename Map>
+	value_type sum(const Map & map)
+	{
+		value_type total = 0;
+		for (const auto & item : map)
+		{
+			total += item.second;
+		}
+		return total;
+	}
+
+	template <typename K, typename H, typename E, typename P, typename A>
+	value_type sum(const nwacc::hash_table<value_type, K, H, E, P, A> & map)
+	{
+		value_type total = 0;
+		for (const auto & item : map)
+		{
+			total += item.element;
+		}
+		return total;
+	}
+
+	/**
+	 * The capacity of a table, in slots or buckets.
+	 */
+	template <typename Map>
+	std::size_t capacity(const Map & map)
+	{
+		return map.bucket_count();
+	}
+
+	template <typename K, typename H, typename E, typename P, typename A>
+	std::size_t capacity(const nwacc::hash_table<value_type, K, H, E, P, A> & map)
+	{
+		return map.stats().capacity;
+	}
+
+	/**
+	 * An empty table with the max load factor of the benchmark, absl ignores it.
+	 */
+	template <typename Map>
+	Map make_table(const benchmark::State & state)
+	{
+		Map map;
+		map.max_load_factor(static_cast<float>(state.range(1)) / 100.0f);
+		return map;
+	}
+
+	/**
+	 * A table holding the hit keys of the benchmark.
+	 */
+	template <typename Map, typename K>
+	Map make_filled_table(const benchmark::State & state)
+	{
+		auto map = make_table<Map>(state);
+		for (const auto & key : keys_for<K>(static_cast<std::size_t>(state.range(0)), false))
+		{
+			insert(map, key, value_type{ 1 });
+		}
+		return map;
+	}
+
+	/**
+	 * Insert every key into a new table, growing from empty.
+	 */
+	template <typename Map, typename K>
+	void insert_benchmark(benchmark::State & state)
+	{
+		const auto & keys = keys_for<K>(static_cast<std::size_t>(state.range(0)), false);
+		for (auto _ : state)
+		{
+			auto map = make_table<Map>(state);
+			for (const auto & key : keys)
+			{
+				insert(map, key, value_type{ 1 });
+			}
+			benchmark::DoNotOptimize(map);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Look up every key of a table, each one is found.
+	 */
+	template <typename Map, typename K>
+	void lookup_hit_benchmark(benchmark::State & state)
+	{
+		const auto map = make_filled_table<Map, K>(state);
+		const auto & keys = keys_for<K>(static_cast<std::size_t>(state.range(0)), false);
+		for (auto _ : state)
+		{
+			std::size_t found = 0;
+			for (const auto & key : keys)
+			{
+				found += contains(map, key) ? 1 : 0;
+			}
+			benchmark::DoNotOptimize(found);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Look up as many keys as the table holds, none of them is found.
+	 */
+	template <typename Map, typename K>
+	void lookup_miss_benchmark(benchmark::State & state)
+	{
+		const auto map = make_filled_table<Map, K>(state);
+		const auto & keys = keys_for<K>(static_cast<std::size_t>(state.range(0)), true);
+		for (auto _ : state)
+		{
+			std::size_t found = 0;
+			for (const auto & key : keys)
+			{
+				found += contains(map, key) ? 1 : 0;
+			}
+			benchmark::DoNotOptimize(found);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Remove every key and insert a missing one in its place, which keeps the
+	 * size steady and leaves tombstones behind in the open addressing tables.
+	 */
+	template <typename Map, typename K>
+	void remove_churn_benchmark(benchmark::State & state)
+	{
+		auto map = make_filled_table<Map, K>(state);
+		const auto & present = keys_for<K>(static_cast<std::size_t>(state.range(0)), false);
+		const auto & missing = keys_for<K>(static_cast<std::size_t>(state.range(0)), true);
+		auto in = &present;
+		auto out = &missing;
+		for (auto _ : state)
+		{
+			for (std::size_t i = 0; i < in->size(); i++)
+			{
+				remove(map, (*in)[i]);
+				insert(map, (*out)[i], value_type{ 1 });
+			}
+			std::swap(in, out);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Rebuild a copy of a full table at twice its capacity. Not every table
+	 * shrinks on rehash, so each rebuild starts from a fresh copy, made with
+	 * the timer stopped.
+	 */
+	template <typename Map, typename K>
+	void rehash_benchmark(benchmark::State & state)
+	{
+		const auto filled = make_filled_table<Map, K>(state);
+		const auto size = capacity(filled);
+		auto map = filled;
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			map = filled;
+			state.ResumeTiming();
+			map.rehash(2 * size);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Rebuild a copy of a full hash_table at twice its capacity, as
+	 * rehash_benchmark does, moving the entries on one thread per hardware thread.
+	 */
+	template <typename Map, typename K>
+	void parallel_rehash_benchmark(benchmark::State & state)
+	{
+		const auto filled = make_filled_table<Map, K>(state);
+		const auto size = capacity(filled);
+		auto map = filled;
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			map = filled;
+			state.ResumeTiming();
+			map.parallel_rehash(2 * size);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Walk every entry of a table.
+	 */
+	template <typename Map, typename K>
+	void iterate_benchmark(benchmark::State & state)
+	{
+		const auto map = make_filled_table<Map, K>(state);
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(sum(map));
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * The keys of a workload, and the indexes of the keys its lookups ask for.
+	 */
+	template <typename K>
+	struct workload_data
+	{
+		std::vector<K> keys;
+		std::vector<std::size_t> lookups;
+	};
+
+	/**
+	 * The seed of every workload, so each run replays the same keys.
+	 */
+	const std::uint64_t kSeed = 20181204;
+
+	workload_data<std::uint64_t> sequential_workload(const std::size_t count)
+	{
+		return { nwacc::workload::sequential_keys(count), nwacc::workload::uniform_indexes(count, count, kSeed) };
+	}
+
+	workload_data<std::uint64_t> clustered_workload(const std::size_t count)
+	{
+		return { nwacc::workload::clustered_keys(count, 64, kSeed), nwacc::workload::uniform_indexes(count, count, kSeed) };
+	}
+
+	workload_data<std::uint64_t> zipf_workload(const std::size_t count)
+	{
+		return { nwacc::workload::uniform_keys(count, kSeed), nwacc::workload::zipf_indexes(count, count, 0.99, kSeed) };
+	}
+
+	workload_data<std::string> url_workload(const std::size_t count)
+	{
+		return { nwacc::workload::url_keys(count, kSeed), nwacc::workload::uniform_indexes(count, count, kSeed) };
+	}
+
+	/**
+	 * The data of a workload, built once per size and kept for the whole run.
+	 */
+	template <typename K, workload_data<K> (*Make)(std::size_t)>
+	const workload_data<K> & workload_for(const std::size_t count)
+	{
+		static std::map<std::size_t, workload_data<K>> cache;
+		auto found = cache.find(count);
+		if (found == cache.end())
+		{
+			found = cache.emplace(count, Make(count)).first;
+		} // else, the data was built by an earlier benchmark, do_nothing();
+		return found->second;
+	}
+
+	/**
+	 * Insert the keys of a workload into a new table, growing from empty.
+	 */
+	template <typename Map, typename K, workload_data<K> (*Make)(std::size_t)>
+	void workload_insert_benchmark(benchmark::State & state)
+	{
+		const auto & data = workload_for<K, Make>(static_cast<std::size_t>(state.range(0)));
+		for (auto _ : state)
+		{
+			Map map;
+			for (const auto & key : data.keys)
+			{
+				insert(map, key, value_type{ 1 });
+			}
+			benchmark::DoNotOptimize(map);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Replay the lookups of a workload against a table holding its keys.
+	 */
+	template <typename Map, typename K, workload_data<K> (*Make)(std::size_t)>
+	void workload_lookup_benchmark(benchmark::State & state)
+	{
+		const auto & data = workload_for<K, Make>(static_cast<std::size_t>(state.range(0)));
+		Map map;
+		for (const auto & key : data.keys)
+		{
+			insert(map, key, value_type{ 1 });
+		}
+		for (auto _ : state)
+		{
+			std::size_t found = 0;
+			for (const auto index : data.lookups)
+			{
+				found += contains(map, data.keys[index]) ? 1 : 0;
+			}
+			benchmark::DoNotOptimize(found);
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(data.lookups.size()));
+	}
+
+	/**
+	 * Replay a mix of Zipfian lookups, inserts, and removes, with the percent
+	 * of lookups given by the second argument.
+	 */
+	template <typename Map>
+	void mixed_benchmark(benchmark::State & state)
+	{
+		const auto count = static_cast<std::size_t>(state.range(0));
+		const auto & keys = workload_for<std::uint64_t, zipf_workload>(count).keys;
+		const auto operations = nwacc::workload::mixed_operations(count, count,
+			static_cast<unsigned>(state.range(1)), 0.99, kSeed);
+		Map map;
+		for (const auto & key : keys)
+		{
+			insert(map, key, value_type{ 1 });
+		}
+		for (auto _ : state)
+		{
+			std::size_t found = 0;
+			for (const auto & step : operations)
+			{
+				switch (step.kind)
+				{
+				case nwacc::workload::operation::kLookup:
+					found += contains(map, keys[step.key]) ? 1 : 0;
+					break;
+				case nwacc::workload::operation::kInsert:
+					insert(map, keys[step.key], value_type{ 1 });
+					break;
+				default:
+					remove(map, keys[step.key]);
+					break;
+				}
+			}
+			benchmark::DoNotOptimize(found);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/**
+	 * Register the workload benchmarks for one table.
+	 * @param name the name of the table, shown after the benchmark name.
+	 */
+	template <typename IntegerMap, typename StringMap>
+	void register_workloads(const std::string & name)
+	{
+		typedef void (*function_type)(benchmark::State &);
+		const std::pair<const char *, function_type> benchmarks[] = {
+			{ "SequentialInsert", workload_insert_benchmark<IntegerMap, std::uint64_t, sequential_workload> },
+			{ "SequentialLookup", workload_lookup_benchmark<IntegerMap, std::uint64_t, sequential_workload> },
+			{ "ClusteredLookup", workload_lookup_benchmark<IntegerMap, std::uint64_t, clustered_workload> },
+			{ "ZipfLookup", workload_lookup_benchmark<IntegerMap, std::uint64_t, zipf_workload> },
+			{ "UrlInsert", workload_insert_benchmark<StringMap, std::string, url_workload> },
+			{ "UrlLookup", workload_lookup_benchmark<StringMap, std::string, url_workload> },
+		};
+
+		for (const auto & entry : benchmarks)
+		{
+			benchmark::RegisterBenchmark((std::string(entry.first) + "/" + name).c_str(), entry.second)
+				->RangeMultiplier(16)->Range(kSmallest, kLargest)->ArgName("size")->Unit(benchmark::kMicrosecond);
+		}
+
+		auto mixed = benchmark::RegisterBenchmark(("Mixed/" + name).c_str(), mixed_benchmark<IntegerMap>);
+		for (auto size = kSmallest; size <= kLargest; size *= 16)
+		{
+			for (const auto reads : { 50, 90, 99 })
+			{
+				mixed->Args({ size, reads });
+			}
+		}
+		mixed->ArgNames({ "size", "read" })->Unit(benchmark::kMicrosecond);
+	}
+
+	/**
+	 * Register every benchmark for one table and key type.
+	 * @param name the name of the table, shown after the benchmark name.
+	 */
+	template <typename Map, typename K>
+	void register_table(const std::string & name)
+	{
+		const std::pair<const char *, void (*)(benchmark::State &)> benchmarks[] = {
+			{ "Insert", insert_benchmark<Map, K> },
+			{ "LookupHit", lookup_hit_benchmark<Map, K> },
+			{ "LookupMiss", lookup_miss_benchmark<Map, K> },
+			{ "RemoveChurn", remove_churn_benchmark<Map, K> },
+			{ "Rehash", rehash_benchmark<Map, K> },
+			{ "Iterate", iterate_benchmark<Map, K> },
+		};
+
+		for (const auto & entry : benchmarks)
+		{
+			auto registered = benchmark::RegisterBenchmark((std::string(entry.first) + "/" + name).c_str(), entry.second);
+			for (auto size = kSmallest; size <= kLargest; size *= 16)
+			{
+				for (const auto load : kLoads)
+				{
+					registered->Args({ size, load });
+				}
+			}
+			registered->ArgNames({ "size", "load" })->Unit(benchmark::kMicrosecond);
+		}
+	}
+
+	/**
+	 * Register every table with one key type.
+	 * @param key_name the name of the key type.
+	 */
+	template <typename K>
+	void register_key(const std::string & key_name)
+	{
+		register_table<nwacc::hash_table<value_type, K>, K>("nwacc::hash_table<" + key_name + ">");
+
+		auto parallel = benchmark::RegisterBenchmark(("ParallelRehash/nwacc::hash_table<" + key_name + ">").c_str(),
+			parallel_rehash_benchmark<nwacc::hash_table<value_type, K>, K>);
+		for (auto size = kSmallest; size <= kLargest; size *= 16)
+		{
+			for (const auto load : kLoads)
+			{
+				parallel->Args({ size, load });
+			}
+		}
+		parallel->ArgNames({ "size", "load" })->Unit(benchmark::kMicrosecond);
+		register_table<std::unordered_map<K, value_type>, K>("std::unordered_map<" + key_name + ">");
+#if defined(NWACC_BENCH_ABSL)
+		register_table<absl::flat_hash_map<K, value_type>, K>("absl::flat_hash_map<" + key_name + ">");
+#endif
+#if defined(NWACC_BENCH_ANKERL)
+		register_table<ankerl::unordered_dense::map<K, value_type>, K>("ankerl::unordered_dense<" + key_name + ">");
+#endif
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	register_key<std::uint64_t>("uint64");
+	register_key<std::string>("string");
+
+	register_workloads<nwacc::hash_table<value_type, std::uint64_t>,
+		nwacc::hash_table<value_type, std::string>>("nwacc::hash_table");
+	register_workloads<nwacc::hash_table<value_type, std::uint64_t, std::hash<std::uint64_t>,
+		std::equal_to<std::uint64_t>, nwacc::prime_policy>,
+		nwacc::hash_table<value_type, std::string, std::hash<std::string>,
+		std::equal_to<std::string>, nwacc::prime_policy>>("nwacc::hash_table<prime_policy>");
+	register_workloads<std::unordered_map<std::uint64_t, value_type>,
+		std::unordered_map<std::string, value_type>>("std::unordered_map");
+#if defined(NWACC_BENCH_ABSL)
+	register_workloads<absl::flat_hash_map<std::uint64_t, value_type>,
+		absl::flat_hash_map<std::string, value_type>>("absl::flat_hash_map");
+#endif
+#if defined(NWACC_BENCH_ANKERL)
+	register_workloads<ankerl::unordered_dense::map<std::uint64_t, value_type>,
+		ankerl::unordered_dense::map<std::string, value_type>>("ankerl::unordered_dense");
+#endif
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 1;
+	} // else, every argument was understood, do_nothing();
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
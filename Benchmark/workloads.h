@@ -0,0 +1,315 @@
+#ifndef WORKLOADS_H_
+#define WORKLOADS_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hash_policy.h"
+
+namespace nwacc {
+
+	/**
+	 * Key and operation generators for the benchmarks. Every generator is
+	 * reproducible, the same arguments and seed always give the same output
+	 * on every platform, because only std::mt19937_64 is used for randomness
+	 * and the standard distributions, whose output differs between standard
+	 * libraries, are avoided.
+	 */
+	namespace workload {
+
+		/**
+		 * A uniform value in [0, range) from the engine.
+		 * @param engine the random engine.
+		 * @param range the number of values, greater than zero.
+		 * @return the value.
+		 */
+		inline std::uint64_t uniform(std::mt19937_64 & engine, const std::uint64_t range)
+		{
+			const auto threshold = (0 - range) % range;
+			std::uint64_t value;
+			do
+			{
+				value = engine();
+			} while (value < threshold);
+			return value % range;
+		}
+
+		/**
+		 * A uniform value in [0, 1) from the engine.
+		 */
+		inline double uniform_real(std::mt19937_64 & engine)
+		{
+			return static_cast<double>(engine() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		/**
+		 * Picks indexes in [0, count) with Zipfian popularity: index i is picked
+		 * with a chance proportional to 1 / (i + 1)^exponent, so a few indexes take
+		 * most of the picks, the way a few keys take most of the traffic of a cache.
+		 * Sampled with the rejection inversion method of Hormann and Derflinger,
+		 * in constant time and memory for any count.
+		 */
+		class zipf_distribution
+		{
+		public:
+			/**
+			 * @param count the number of indexes, greater than zero.
+			 * @param exponent the skew, greater than zero, 0.99 is a common choice.
+			 */
+			zipf_distribution(const std::uint64_t count, const double exponent = 0.99)
+				: count(count), exponent(exponent)
+			{
+				this->integral_first = this->h_integral(1.5) - 1.0;
+				this->integral_last = this->h_integral(static_cast<double>(count) + 0.5);
+				this->squeeze = 2.0 - this->h_integral_inverse(this->h_integral(2.5) - this->h(2.0));
+			}
+
+			/**
+			 * Pick the next index.
+			 * @param engine the random engine.
+			 * @return the index, 0 being the most popular.
+			 */
+			std::uint64_t operator()(std::mt19937_64 & engine) const
+			{
+				while (true)
+				{
+					const auto u = this->integral_last + uniform_real(engine) * (this->integral_first - this->integral_last);
+					const auto x = this->h_integral_inverse(u);
+					auto k = static_cast<std::uint64_t>(x + 0.5);
+					if (k < 1)
+					{
+						k = 1;
+					}
+					else if (k > this->count)
+					{
+						k = this->count;
+					} // else, k is in range, do_nothing();
+
+					const auto rank = static_cast<double>(k);
+					if (rank - x <= this->squeeze || u >= this->h_integral(rank + 0.5) - this->h(rank))
+					{
+						return k - 1;
+					} // else, rejected, draw again, do_nothing();
+				}
+			}
+
+		private:
+			double h(const double x) const
+			{
+				return std::exp(-this->exponent * std::log(x));
+			}
+
+			double h_integral(const double x) const
+			{
+				const auto log_x = std::log(x);
+				return helper2((1.0 - this->exponent) * log_x) * log_x;
+			}
+
+			double h_integral_inverse(const double x) const
+			{
+				auto t = x * (1.0 - this->exponent);
+				if (t < -1.0)
+				{
+					t = -1.0;
+				} // else, t is in range, do_nothing();
+				return std::exp(helper1(t) * x);
+			}
+
+			/**
+			 * log(1 + x) / x, accurate near zero.
+			 */
+			static double helper1(const double x)
+			{
+				return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+			}
+
+			/**
+			 * (exp(x) - 1) / x, accurate near zero.
+			 */
+			static double helper2(const double x)
+			{
+				return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+			}
+
+			std::uint64_t count;
+			double exponent;
+			double integral_first;
+			double integral_last;
+			double squeeze;
+		};
+
+		/**
+		 * The integers first, first + 1, and so on, the worst case for an identity
+		 * std::hash reduced with a modulo, since consecutive keys fill consecutive slots.
+		 * @param count the number of keys.
+		 * @param first the first key.
+		 * @return the keys, in order.
+		 */
+		inline std::vector<std::uint64_t> sequential_keys(const std::size_t count, const std::uint64_t first = 0)
+		{
+			std::vector<std::uint64_t> keys(count);
+			for (std::size_t i = 0; i < count; i++)
+			{
+				keys[i] = first + i;
+			}
+			return keys;
+		}
+
+		/**
+		 * Distinct keys spread evenly over all 64 bit values.
+		 * @param count the number of keys.
+		 * @param seed picks the keys.
+		 * @return the keys.
+		 */
+		inline std::vector<std::uint64_t> uniform_keys(const std::size_t count, const std::uint64_t seed)
+		{
+			std::vector<std::uint64_t> keys(count);
+			const auto offset = mix(seed);
+			for (std::size_t i = 0; i < count; i++)
+			{ // mix is a bijection, so distinct inputs give distinct keys.
+				keys[i] = mix(offset + i);
+			}
+			return keys;
+		}
+
+		/**
+		 * Distinct keys in runs of consecutive integers that start at random
+		 * places, like the ids handed out in batches by many services.
+		 * @param count the number of keys.
+		 * @param run_length the number of keys of a run, at most 2^20.
+		 * @param seed picks the start of every run.
+		 * @return the keys, a run at a time.
+		 */
+		inline std::vector<std::uint64_t> clustered_keys(const std::size_t count, const std::size_t run_length,
+			const std::uint64_t seed)
+		{
+			std::vector<std::uint64_t> keys(count);
+			const auto offset = mix(seed);
+			for (std::size_t i = 0; i < count; i++)
+			{ // the runs start on random multiples of 2^20, two only overlap if the low 44 bits of their starts collide.
+				const auto run = static_cast<std::uint64_t>(i / run_length);
+				keys[i] = (mix(offset + run) << 20) + i % run_length;
+			}
+			return keys;
+		}
+
+		/**
+		 * Distinct long URL like strings sharing a few hosts and path prefixes,
+		 * so the keys differ only near the end and comparing them is expensive.
+		 * @param count the number of keys.
+		 * @param seed picks the hosts, paths, and query strings.
+		 * @return the keys, from about 60 to 120 characters long.
+		 */
+		inline std::vector<std::string> url_keys(const std::size_t count, const std::uint64_t seed)
+		{
+			static const char * const hosts[] = { "www.example.com", "static.example.net", "api.example.org",
+				"cdn.images.example.com" };
+			static const char * const sections[] = { "products", "articles", "users", "search", "assets/img" };
+
+			std::mt19937_64 engine(seed);
+			std::vector<std::string> keys(count);
+			for (std::size_t i = 0; i < count; i++)
+			{
+				auto & key = keys[i];
+				key = "https://";
+				key += hosts[uniform(engine, 4)];
+				key += '/';
+				key += sections[uniform(engine, 5)];
+				for (auto depth = uniform(engine, 4); depth-- > 0;)
+				{
+					key += '/';
+					key += std::to_string(uniform(engine, 100000));
+				}
+				key += "/index.html?session=";
+				key += std::to_string(engine() >> 16);
+				key += "&id=";
+				key += std::to_string(i);
+			}
+			return keys;
+		}
+
+		/**
+		 * Indexes picked uniformly from [0, range).
+		 * @param count the number of indexes.
+		 * @param range the number of values, greater than zero.
+		 * @param seed picks the indexes.
+		 * @return the indexes.
+		 */
+		inline std::vector<std::size_t> uniform_indexes(const std::size_t count, const std::size_t range,
+			const std::uint64_t seed)
+		{
+			std::mt19937_64 engine(seed);
+			std::vector<std::size_t> indexes(count);
+			for (auto & index : indexes)
+			{
+				index = static_cast<std::size_t>(uniform(engine, range));
+			}
+			return indexes;
+		}
+
+		/**
+		 * Indexes picked from [0, range) with Zipfian popularity, see zipf_distribution.
+		 * @param count the number of indexes.
+		 * @param range the number of values, greater than zero.
+		 * @param exponent the skew.
+		 * @param seed picks the indexes.
+		 * @return the indexes.
+		 */
+		inline std::vector<std::size_t> zipf_indexes(const std::size_t count, const std::size_t range,
+			const double exponent, const std::uint64_t seed)
+		{
+			std::mt19937_64 engine(seed);
+			const zipf_distribution popularity(range, exponent);
+			std::vector<std::size_t> indexes(count);
+			for (auto & index : indexes)
+			{
+				index = static_cast<std::size_t>(popularity(engine));
+			}
+			return indexes;
+		}
+
+		/**
+		 * One step of a mixed workload, on the key at an index of the key set.
+		 */
+		struct operation
+		{
+			enum kind_type : std::uint8_t { kLookup, kInsert, kRemove };
+
+			kind_type kind;
+			std::size_t key;
+		};
+
+		/**
+		 * A mix of lookups, inserts, and removes over a key set, for a driver to
+		 * replay against a table that starts out holding every key. The writes are
+		 * split evenly between inserts and removes, so the size stays steady.
+		 * @param count the number of operations.
+		 * @param key_count the number of keys in the key set.
+		 * @param read_percent the percent of operations that are lookups, 0 to 100.
+		 * @param exponent the Zipfian skew of the keys picked, 0 for uniform picks.
+		 * @param seed picks the operations and keys.
+		 * @return the operations.
+		 */
+		inline std::vector<operation> mixed_operations(const std::size_t count, const std::size_t key_count,
+			const unsigned read_percent, const double exponent, const std::uint64_t seed)
+		{
+			std::mt19937_64 engine(seed);
+			const zipf_distribution popularity(key_count, exponent > 0.0 ? exponent : 0.99);
+			std::vector<operation> operations(count);
+			for (auto & step : operations)
+			{
+				const auto roll = uniform(engine, 200);
+				step.kind = roll < 2 * read_percent ? operation::kLookup
+					: roll % 2 == 0 ? operation::kInsert : operation::kRemove;
+				step.key = static_cast<std::size_t>(exponent > 0.0 ? popularity(engine) : uniform(engine, key_count));
+			}
+			return operations;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ARENA_HASH_TABLE_H_
+#define ARENA_HASH_TABLE_H_
+
+#include <cstddef>
+#include <functional>
+
+#include "arena_resource.h"
+#include "hash_table.h"
+
+namespace nwacc {
+
+	/**
+	 * Holds the arena of an arena_hash_table, as a base so it is built before
+	 * the hash_table and destroyed after it.
+	 */
+	class arena_holder
+	{
+	protected:
+		explicit arena_holder(const std::size_t size_limit) : arena(size_limit) { }
+
+		arena_resource arena;
+	};
+
+	/**
+	 * A hash_table that owns an arena_resource. Every std::pmr T and K stored in it,
+	 * such as short std::pmr::string keys, is bump allocated from the arena up to
+	 * its size limit, and make_empty() frees all of them at once by releasing the
+	 * arena. The slot storage comes from the default resource and is kept by make_empty().
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename Policy = power_of_two_policy>
+	class arena_hash_table : private arena_holder,
+		public hash_table<T, K, Hash, KeyEqual, Policy, arena_allocator<T>>
+	{
+	public:
+		typedef hash_table<T, K, Hash, KeyEqual, Policy, arena_allocator<T>> table_type;
+
+		/**
+		 * Create an empty arena_hash_table.
+		 * @param size the number of slots to allocate.
+		 * @param size_limit the largest allocation of a T or K served from the arena.
+		 */
+		explicit arena_hash_table(int size = 7, const std::size_t size_limit = 256,
+			const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual())
+			: arena_holder(size_limit), table_type(size, hash, equal, arena_allocator<T>(&this->arena)) { }
+
+		arena_hash_table(const arena_hash_table &) = delete;
+
+		arena_hash_table & operator=(const arena_hash_table &) = delete;
+
+		/**
+		 * Remove every entry and give every slab of the arena back at once.
+		 */
+		void make_empty()
+		{
+			this->table_type::make_empty();
+			this->arena.release();
+		}
+
+		/**
+		 * The arena the T and K of the entries are allocated from.
+		 */
+		const arena_resource & resource() const
+		{
+			return this->arena;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef ARENA_RESOURCE_H_
+#define ARENA_RESOURCE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace nwacc {
+
+	/**
+	 * A std::pmr::memory_resource that bump allocates small blocks, up to a size
+	 * limit, out of large slabs taken from an upstream resource. Freeing a small
+	 * block does nothing, every slab is given back at once by release().
+	 * Larger blocks are passed straight to the upstream resource and freed one by one.
+	 */
+	class arena_resource : public std::pmr::memory_resource
+	{
+	public:
+		/**
+		 * Create an empty arena, no slab is taken until the first small allocation.
+		 * @param size_limit the largest block served from the slabs.
+		 * @param slab_size the number of bytes taken from upstream for each slab.
+		 * @param upstream the resource the slabs and the large blocks come from.
+		 */
+		explicit arena_resource(const std::size_t size_limit = 256, const std::size_t slab_size = 64 * 1024,
+			std::pmr::memory_resource * upstream = std::pmr::get_default_resource())
+			: limit(size_limit), slab_bytes(std::max(slab_size, size_limit + alignof(std::max_align_t))),
+			upstream(upstream) { }
+
+		arena_resource(const arena_resource &) = delete;
+
+		arena_resource & operator=(const arena_resource &) = delete;
+
+		~arena_resource() override
+		{
+			this->release();
+		}
+
+		/**
+		 * Give every slab back to the upstream resource. Every small block handed
+		 * out so far is freed, the large blocks are not touched.
+		 */
+		void release()
+		{
+			while (this->head != nullptr)
+			{
+				auto next = this->head->next;
+				this->upstream->deallocate(this->head, this->head->size, alignof(std::max_align_t));
+				this->head = next;
+			}
+			this->position = nullptr;
+			this->end = nullptr;
+			this->slab_total = 0;
+		}
+
+		/**
+		 * The largest block served from the slabs.
+		 */
+		std::size_t size_limit() const
+		{
+			return this->limit;
+		}
+
+		/**
+		 * The number of slabs currently taken from the upstream resource.
+		 */
+		std::size_t slab_count() const
+		{
+			return this->slab_total;
+		}
+
+		/**
+		 * The resource the slabs and the large blocks come from.
+		 */
+		std::pmr::memory_resource * upstream_resource() const
+		{
+			return this->upstream;
+		}
+
+	private:
+		/**
+		 * The header at the start of every slab, linking the slabs for release().
+		 */
+		struct slab
+		{
+			slab * next;
+			std::size_t size;
+		};
+
+		std::size_t limit;
+
+		std::size_t slab_bytes;
+
+		std::pmr::memory_resource * upstream;
+
+		slab * head{};
+
+		unsigned char * position{};
+
+		unsigned char * end{};
+
+		std::size_t slab_total{};
+
+		void * do_allocate(const std::size_t bytes, const std::size_t alignment) override
+		{
+			if (bytes > this->limit || alignment > alignof(std::max_align_t))
+			{
+				return this->upstream->allocate(bytes, alignment);
+			} // else, a small block, served from the slab, do_nothing();
+
+			auto current = this->align(this->position, alignment);
+			if (current == nullptr || current + bytes > this->end)
+			{ // the slab is used up, the rest of it is wasted until release().
+				this->add_slab();
+				current = this->align(this->position, alignment);
+			} // else, the block fits in the current slab, do_nothing();
+			this->position = current + bytes;
+			return current;
+		}
+
+		void do_deallocate(void * block, const std::size_t bytes, const std::size_t alignment) override
+		{
+			if (bytes > this->limit || alignment > alignof(std::max_align_t))
+			{
+				this->upstream->deallocate(block, bytes, alignment);
+			} // else, small blocks go away with their slab, do_nothing();
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+		{
+			return this == &other;
+		}
+
+		/**
+		 * Round a position in the current slab up to the alignment.
+		 */
+		static unsigned char * align(unsigned char * at, const std::size_t alignment)
+		{
+			if (at == nullptr)
+			{
+				return nullptr;
+			} // else, there is a slab, do_nothing();
+			const auto address = reinterpret_cast<std::uintptr_t>(at);
+			return at + ((alignment - address % alignment) % alignment);
+		}
+
+		/**
+		 * Take a new slab from the upstream resource and bump allocate from it.
+		 */
+		void add_slab()
+		{
+			auto memory = static_cast<unsigned char *>(
+				this->upstream->allocate(this->slab_bytes, alignof(std::max_align_t)));
+			this->head = ::new (memory) slab{ this->head, this->slab_bytes };
+			this->position = memory + sizeof(slab);
+			this->end = memory + this->slab_bytes;
+			++this->slab_total;
+		}
+	};
+
+	/**
+	 * A std::pmr::polymorphic_allocator over an arena_resource that takes its own
+	 * storage from the upstream resource of the arena. Given to a hash_table, the
+	 * slot storage never lives in the slabs, so the arena can be released while
+	 * the hash_table is kept, and the std::pmr T and K stored in the hash_table
+	 * still get the arena.
+	 */
+	template <typename T>
+	class arena_allocator : public std::pmr::polymorphic_allocator<T>
+	{
+	public:
+		typedef T value_type;
+
+		arena_allocator(arena_resource * arena) noexcept
+			: std::pmr::polymorphic_allocator<T>(arena), arena(arena) { }
+
+		template <typename U>
+		arena_allocator(const arena_allocator<U> & other) noexcept
+			: std::pmr::polymorphic_allocator<T>(other.arena_resource_ptr()), arena(other.arena_resource_ptr()) { }
+
+		T * allocate(const std::size_t count)
+		{
+			return static_cast<T *>(this->arena->upstream_resource()->allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T * block, const std::size_t count)
+		{
+			this->arena->upstream_resource()->deallocate(block, count * sizeof(T), alignof(T));
+		}
+
+		/**
+		 * A copy of a container keeps using the same arena.
+		 */
+		arena_allocator select_on_container_copy_construction() const
+		{
+			return *this;
+		}
+
+		arena_resource * arena_resource_ptr() const
+		{
+			return this->arena;
+		}
+
+	private:
+		arena_resource * arena;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const arena_allocator<T> & lhs, const arena_allocator<U> & rhs)
+	{
+		return lhs.arena_resource_ptr() == rhs.arena_resource_ptr();
+	}
+
+	template <typename T, typename U>
+	bool operator!=(const arena_allocator<T> & lhs, const arena_allocator<U> & rhs)
+	{
+		return !(lhs == rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef HASH_POLICY_H_
+#define HASH_POLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace nwacc {
+
+	/**
+	 * Scramble the bits of a hash code so that weak hashes (std::hash on integers
+	 * is the identity on most standard libraries) still spread over every bucket.
+	 * This is the 64 bit finalizer from MurmurHash3.
+	 * @param hash the hash code produced by the hash function.
+	 * @return the mixed hash code.
+	 */
+	constexpr std::size_t mix(const std::size_t hash)
+	{
+		auto mixed = static_cast<std::uint64_t>(hash);
+		mixed ^= mixed >> 33;
+		mixed *= 0xff51afd7ed558ccdULL;
+		mixed ^= mixed >> 33;
+		mixed *= 0xc4ceb9fe1a85ec53ULL;
+		mixed ^= mixed >> 33;
+		return static_cast<std::size_t>(mixed);
+	}
+
+	/**
+	 * Ask the cpu to start loading the cache line holding the address, used by
+	 * the batched lookups to overlap the cache misses of many keys.
+	 * @param address any address, it is never dereferenced.
+	 */
+	inline void prefetch(const void * address)
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(address);
+#else
+		(void) address;
+#endif
+	}
+
+	/**
+	 * Detect a hash or equality function object declaring is_transparent, which
+	 * means it accepts any type comparable with the key, not just the key type.
+	 */
+	template <typename F, typename = void>
+	struct is_transparent : std::false_type { };
+
+	template <typename F>
+	struct is_transparent<F, std::void_t<typename F::is_transparent>> : std::true_type { };
+
+	/**
+	 * Enables the heterogeneous lookup overloads of a table, only when both its
+	 * hash and its equality function objects are transparent.
+	 */
+	template <typename Hash, typename KeyEqual>
+	using enable_if_transparent = typename std::enable_if<
+		is_transparent<Hash>::value && is_transparent<KeyEqual>::value>::type;
+
+	/**
+	 * Decides if a hash_table keeps the full hash code of every entry in its slot.
+	 * With the codes cached, growing moves every entry without calling the hasher,
+	 * and a probe only compares the keys whose hash codes match, at the cost of
+	 * one std::size_t per slot. It is on for every key type that is not a number,
+	 * enum, or pointer, such as std::string, where hashing and comparing are the
+	 * expensive part. Specialize it for a key type to force either choice.
+	 */
+	template <typename K>
+	struct cache_hash_code : std::integral_constant<bool,
+		!std::is_arithmetic<K>::value && !std::is_enum<K>::value && !std::is_pointer<K>::value> { };
+
+	/**
+	 * Capacity policy that keeps the hash_table a power of two in size.
+	 * The home bucket is found with a mask instead of a modulo, and the probe
+	 * sequence walks the triangular numbers, which visits every slot of a
+	 * power of two table exactly once.
+	 */
+	struct power_of_two_policy
+	{
+		/**
+		 * Find the smallest power of two that can hold the requested number of slots.
+		 * @param number the requested number of slots.
+		 * @return the capacity to allocate.
+		 */
+		static std::size_t next_size(const std::size_t number)
+		{
+			std::size_t size = 4;
+			while (size < number) size <<= 1;
+			return size;
+		}
+
+		/**
+		 * Reduce a hash code to the home bucket of a table.
+		 * @param hash the hash code produced by the hash function.
+		 * @param size the capacity of the table, a power of two.
+		 * @return the home bucket in the range [0, size).
+		 */
+		static std::size_t index(const std::size_t hash, const std::size_t size)
+		{
+			return mix(hash) & (size - 1);
+		}
+
+		/**
+		 * Move to the next slot of the probe sequence.
+		 * @param position the slot that was just checked.
+		 * @param off_set the distance to the next slot, updated for the following probe.
+		 * @param size the capacity of the table.
+		 * @return the next slot to check.
+		 */
+		static std::size_t probe(const std::size_t position, std::size_t & off_set, const std::size_t size)
+		{
+			return (position + off_set++) & (size - 1);
+		}
+
+		/**
+		 * The highest load factor the probe sequence supports. The triangular
+		 * sequence visits every slot, so only a margin of empty slots is kept.
+		 */
+		static float max_load_factor()
+		{
+			return 0.95f;
+		}
+	};
+
+	/**
+	 * Capacity policy that keeps the hash_table a prime number in size and reduces
+	 * the hash code with a modulo. This is the original policy of the hash_table,
+	 * it is slower but does not depend on the quality of the hash function.
+	 */
+	struct prime_policy
+	{
+		/**
+		 * Determine if the current value is a prime number or not.
+		 * @param number the value being checked for primeness.
+		 * @return true if the current number is prime.
+		 * @return false if the current number is not prime.
+		 */
+		static constexpr bool is_prime(const std::size_t number)
+		{
+			if (number == 2 || number == 3) return true;
+			if (number == 1 || number % 2 == 0) return false;
+			for (std::size_t counter = 3; counter * counter <= number; counter += 2)
+				if (number % counter == 0) return false;
+
+			return true;
+		}
+
+		/**
+		 * Find the next prime number at or above the value.
+		 * @param number the value to start searching from.
+		 * @return the next prime number.
+		 */
+		static constexpr std::size_t next_prime(std::size_t number)
+		{
+			if (number % 2 == 0) ++number;
+			while (!is_prime(number)) number += 2;
+			return number;
+		}
+
+		/**
+		 * Find the smallest prime that can hold the requested number of slots.
+		 * @param number the requested number of slots.
+		 * @return the capacity to allocate.
+		 */
+		static constexpr std::size_t next_size(const std::size_t number)
+		{
+			return next_prime(number);
+		}
+
+		/**
+		 * Reduce a hash code to the home bucket of a table.
+		 * @param hash the hash code produced by the hash function.
+		 * @param size the capacity of the table.
+		 * @return the home bucket in the range [0, size).
+		 */
+		static std::size_t index(const std::size_t hash, const std::size_t size)
+		{
+			return hash % size;
+		}
+
+		/**
+		 * Move to the next slot of the quadratic probe sequence.
+		 * @param position the slot that was just checked.
+		 * @param off_set the distance to the next slot, updated for the following probe.
+		 * @param size the capacity of the table.
+		 * @return the next slot to check.
+		 */
+		static std::size_t probe(std::size_t position, std::size_t & off_set, const std::size_t size)
+		{
+			position += off_set;
+			off_set += 2;
+			if (position >= size)
+			{
+				position -= size;
+			} // else, we have not ran outside the size, do_nothing();
+			return position;
+		}
+
+		/**
+		 * The highest load factor the probe sequence supports. The quadratic
+		 * sequence of a prime size is only sure to find a free slot while at
+		 * least half of the slots are empty.
+		 */
+		static float max_load_factor()
+		{
+			return 0.5f;
+		}
+	};
+
+	/**
+	 * Capacity policy that keeps the prime sizes and quadratic probing of the
+	 * prime_policy, but finds the home bucket with Lemire's multiply-shift
+	 * reduction instead of a modulo, so no division is done on a lookup.
+	 */
+	struct fast_range_policy : prime_policy
+	{
+		/**
+		 * Reduce a hash code to the home bucket of a table.
+		 * @param hash the hash code produced by the hash function.
+		 * @param size the capacity of the table, must fit in 32 bits.
+		 * @return the home bucket in the range [0, size).
+		 */
+		static std::size_t index(const std::size_t hash, const std::size_t size)
+		{
+			const auto mixed = static_cast<std::uint32_t>(mix(hash) >> (sizeof(std::size_t) * 8 - 32));
+			return static_cast<std::size_t>((static_cast<std::uint64_t>(mixed) * size) >> 32);
+		}
+	};
+
+	/**
+	 * Capacity policy of a cache_table, the power_of_two_policy with a reference
+	 * bit kept next to the type of every slot, see reference_bits.
+	 */
+	struct clock_policy : power_of_two_policy { };
+
+	/**
+	 * Decides if a hash_table keeps a reference byte next to the type of every
+	 * slot, cleared when an entry is placed and set by every non-const lookup
+	 * finding it, for the CLOCK eviction of a cache_table. It is only on for the
+	 * clock_policy, specialize it for another policy to keep the bytes too.
+	 */
+	template <typename Policy>
+	struct reference_bits : std::is_base_of<clock_policy, Policy> { };
+}
+
+#endif
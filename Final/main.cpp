@@ -1,5 +1,6 @@
 #include <iostream>
 #include <functional>
+#include <random>
 #include <string>
 
 #include "hash_table.h"
@@ -9,8 +10,9 @@
 /**
  * Generate a random string that contains random
  * letters from the alphabet.
+ * @param engine the random engine, seeded so every run prints the same table.
  */
-std::string print_random_string()
+std::string print_random_string(std::mt19937 & engine)
 {
 	const auto alphabet_length = 26;
 	const auto rand_string_size = 3;
@@ -21,9 +23,10 @@ std::string print_random_string()
 									   'o', 'p', 'q', 'r', 's', 't', 'u',
 									   'v', 'w', 'x', 'y', 'z' };
 
-	for (auto i = 0; i <= rand_string_size; i++)
+	std::uniform_int_distribution<int> letter(0, alphabet_length - 1);
+	for (auto i = 0; i < rand_string_size; i++)
 	{
-		new_string += new_string + alphabet[rand() % alphabet_length];
+		new_string += alphabet[letter(engine)];
 	}
 
 	return new_string;
@@ -43,12 +46,17 @@ int main()
 	 */
 	nwacc::hash_table<std::string, double> table(hash_size);
 
+	/**
+	 * The random engine behind the strings and keys, with a fixed seed.
+	 */
+	std::mt19937 engine(50);
+
 	/**
 	 * Insert random string keys and double values into the hash_table.
 	 */
 	for (auto x = 0; x <= hash_size; x++)
 	{
-		table.insert(print_random_string(), static_cast<double>(rand()));
+		table.insert(print_random_string(engine), static_cast<double>(engine()));
 	}
 
 	/**
@@ -0,0 +1,183 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nwacc {
+
+	/**
+	 * A whole file mapped read only into memory, unmapped again when destroyed.
+	 * The pages are loaded by the operating system on first touch, so opening
+	 * even a very large file costs no reads until its bytes are used.
+	 */
+	class mapped_file
+	{
+	public:
+		/**
+		 * Map the file.
+		 * @param path the file to map, which must exist and not be empty.
+		 * @throws std::runtime_error if the file can not be opened or mapped.
+		 */
+		explicit mapped_file(const std::string & path)
+		{
+#if defined(_WIN32)
+			this->file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (this->file == INVALID_HANDLE_VALUE)
+			{
+				throw std::runtime_error("Could not open " + path);
+			} // else, the file is open, do_nothing();
+
+			LARGE_INTEGER length;
+			if (!::GetFileSizeEx(this->file, &length) || length.QuadPart == 0)
+			{
+				this->close();
+				throw std::runtime_error("Could not map the empty file " + path);
+			} // else, there is something to map, do_nothing();
+			this->length = static_cast<std::size_t>(length.QuadPart);
+
+			this->mapping = ::CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (this->mapping != nullptr)
+			{
+				this->bytes = static_cast<const unsigned char *>(::MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+			} // else, the mapping failed, do_nothing();
+#else
+			this->descriptor = ::open(path.c_str(), O_RDONLY);
+			if (this->descriptor < 0)
+			{
+				throw std::runtime_error("Could not open " + path);
+			} // else, the file is open, do_nothing();
+
+			struct stat status;
+			if (::fstat(this->descriptor, &status) != 0 || status.st_size == 0)
+			{
+				this->close();
+				throw std::runtime_error("Could not map the empty file " + path);
+			} // else, there is something to map, do_nothing();
+			this->length = static_cast<std::size_t>(status.st_size);
+
+			auto address = ::mmap(nullptr, this->length, PROT_READ, MAP_SHARED, this->descriptor, 0);
+			if (address != MAP_FAILED)
+			{
+				this->bytes = static_cast<const unsigned char *>(address);
+			} // else, the mapping failed, do_nothing();
+#endif
+			if (this->bytes == nullptr)
+			{
+				this->close();
+				throw std::runtime_error("Could not map " + path);
+			} // else, the file is mapped, do_nothing();
+		}
+
+		mapped_file(const mapped_file & rhs) = delete;
+		mapped_file & operator=(const mapped_file & rhs) = delete;
+
+		mapped_file(mapped_file && rhs) noexcept
+		{
+			this->swap(rhs);
+		}
+
+		mapped_file & operator=(mapped_file && rhs) noexcept
+		{
+			mapped_file moved(std::move(rhs));
+			this->swap(moved);
+			return *this;
+		}
+
+		~mapped_file()
+		{
+			this->close();
+		}
+
+		/**
+		 * The first byte of the mapping, the mapping starts on a page boundary.
+		 */
+		const unsigned char * data() const
+		{
+			return this->bytes;
+		}
+
+		/**
+		 * The number of bytes mapped, which is the size of the file.
+		 */
+		std::size_t size() const
+		{
+			return this->length;
+		}
+
+	private:
+		void swap(mapped_file & rhs) noexcept
+		{
+#if defined(_WIN32)
+			std::swap(this->file, rhs.file);
+			std::swap(this->mapping, rhs.mapping);
+#else
+			std::swap(this->descriptor, rhs.descriptor);
+#endif
+			std::swap(this->bytes, rhs.bytes);
+			std::swap(this->length, rhs.length);
+		}
+
+		void close() noexcept
+		{
+#if defined(_WIN32)
+			if (this->bytes != nullptr)
+			{
+				::UnmapViewOfFile(this->bytes);
+			} // else, nothing is mapped, do_nothing();
+			if (this->mapping != nullptr)
+			{
+				::CloseHandle(this->mapping);
+			} // else, there is no mapping, do_nothing();
+			if (this->file != INVALID_HANDLE_VALUE)
+			{
+				::CloseHandle(this->file);
+			} // else, there is no file, do_nothing();
+			this->file = INVALID_HANDLE_VALUE;
+			this->mapping = nullptr;
+#else
+			if (this->bytes != nullptr)
+			{
+				::munmap(const_cast<unsigned char *>(this->bytes), this->length);
+			} // else, nothing is mapped, do_nothing();
+			if (this->descriptor >= 0)
+			{
+				::close(this->descriptor);
+			} // else, there is no file, do_nothing();
+			this->descriptor = -1;
+#endif
+			this->bytes = nullptr;
+			this->length = 0;
+		}
+
+#if defined(_WIN32)
+		HANDLE file{ INVALID_HANDLE_VALUE };
+		HANDLE mapping{};
+#else
+		int descriptor{ -1 };
+#endif
+
+		const unsigned char * bytes{};
+		std::size_t length{};
+	};
+}
+
+#endif
@@ -0,0 +1,536 @@
+#ifndef READ_MOSTLY_HASH_TABLE_H_
+#define READ_MOSTLY_HASH_TABLE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include "hash_policy.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace nwacc {
+
+	/**
+	 * Open addressing hash table for read-mostly workloads, where readers never
+	 * take a lock and never write to a slot.
+	 *
+	 * Writers are serialized by a mutex. Every slot is guarded by a sequence
+	 * lock: a writer makes the version odd, changes the slot, then makes it even
+	 * again, and a reader copies the slot and retries if the version moved.
+	 * Growing builds a new array off to the side, publishes it with one atomic
+	 * store, and frees the old array after a grace period, once every reader
+	 * that could still be probing it has left. Readers announce themselves on
+	 * one of kStripes cache line sized counters, handed out to the threads in
+	 * turn, so up to kStripes reading threads never share a counter line. With
+	 * more threads the stripes are shared, and the contention is reduced
+	 * rather than gone.
+	 *
+	 * Readers copy keys and values out of slots that may be changing under them,
+	 * so both must be trivially copyable.
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename Policy = power_of_two_policy>
+	class read_mostly_hash_table
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "read_mostly_hash_table needs a trivially copyable T");
+		static_assert(std::is_trivially_copyable<K>::value, "read_mostly_hash_table needs a trivially copyable K");
+
+	public:
+		/**
+		 * Create an empty read_mostly_hash_table.
+		 * @param size the number of slots to allocate.
+		 */
+		explicit read_mostly_hash_table(int size = 7, const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual())
+			: hasher(hash), key_equal(equal)
+		{
+			this->current.store(new slot_table(Policy::next_size(size)), std::memory_order_relaxed);
+		}
+
+		read_mostly_hash_table(const read_mostly_hash_table &) = delete;
+
+		read_mostly_hash_table & operator=(const read_mostly_hash_table &) = delete;
+
+		~read_mostly_hash_table()
+		{
+			delete this->current.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Determine if the table contains an entry with a matching key. Never blocks.
+		 */
+		bool contains(const K & key) const
+		{
+			payload found;
+			return this->read(key, found);
+		}
+
+		/**
+		 * Copy the value stored under the key. Never blocks.
+		 * @param key the key being searched for.
+		 * @param value set to the value when the key is found.
+		 * @return true if the key was found.
+		 */
+		bool find(const K & key, T & value) const
+		{
+			payload found;
+			if (!this->read(key, found))
+			{
+				return false;
+			} // else, the key exists, do_nothing();
+			value = found.element;
+			return true;
+		}
+
+		/**
+		 * Returns a copy of the value stored under the key. Never blocks.
+		 * If the key does not exist in the table throw a length error.
+		 */
+		T get_key(const K & key) const
+		{
+			payload found;
+			if (!this->read(key, found))
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return found.element;
+		}
+
+		/**
+		 * Insert the value under the key. If the key is already in the table its
+		 * value is replaced. Waits for other writers, never for readers, except
+		 * for the grace period after growing.
+		 * @return true if a new entry was inserted.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			std::lock_guard<std::mutex> guard(this->writer);
+			auto table = this->current.load(std::memory_order_relaxed);
+			const auto code = this->hasher(key);
+			auto current_position = this->find_insert_position(*table, code, key);
+			auto & found = table->slots[current_position];
+			if (found.type.load(std::memory_order_relaxed) == kActive)
+			{
+				write_slot(found, kActive, payload{ key, value });
+				return false;
+			} // else, the key is new, do_nothing();
+
+			const auto reused = found.type.load(std::memory_order_relaxed) == kDeleted;
+			if (!reused && this->used(*table) + 1 > threshold_for(table->size))
+			{ // the entry would take the array past the max load factor, counting the tombstones.
+				table = this->grow(*table);
+				current_position = this->find_insert_position(*table, code, key);
+			} // else we are within the load factor do_nothing();
+
+			auto & slot = table->slots[current_position];
+			if (slot.type.load(std::memory_order_relaxed) == kDeleted)
+			{
+				--table->deleted_size;
+			} // else, an empty slot is used, do_nothing();
+			write_slot(slot, kActive, payload{ key, value });
+			this->current_size.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		/**
+		 * Removes the entry stored under the key, leaving a tombstone.
+		 * @return true if an entry was removed.
+		 */
+		bool remove(const K & key)
+		{
+			std::lock_guard<std::mutex> guard(this->writer);
+			auto table = this->current.load(std::memory_order_relaxed);
+			const auto current_position = this->find_insert_position(*table, this->hasher(key), key);
+			auto & found = table->slots[current_position];
+			if (found.type.load(std::memory_order_relaxed) != kActive)
+			{
+				return false;
+			} // else, the key exists, do_nothing();
+			write_slot(found, kDeleted, load_payload(found));
+			++table->deleted_size;
+			this->current_size.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		/**
+		 * Remove every entry by publishing a new empty array of the same size.
+		 */
+		void make_empty()
+		{
+			std::lock_guard<std::mutex> guard(this->writer);
+			const auto table = this->current.load(std::memory_order_relaxed);
+			this->publish(new slot_table(table->size));
+			this->current_size.store(0, std::memory_order_relaxed);
+		}
+
+		/**
+		 * The number of entries.
+		 */
+		std::size_t size() const
+		{
+			return this->current_size.load(std::memory_order_relaxed);
+		}
+
+	private:
+		/**
+		 * enum data structure containing the three types.
+		 */
+		enum entry_type : std::uint8_t { kActive, kEmpty, kDeleted };
+
+		/**
+		 * The number of reader counters, and the size of a cache line on the targets we build for.
+		 */
+		enum { kStripes = 32, kCacheLine = 64 };
+
+		/**
+		 * The key and value of a slot, as copied in and out by the sequence lock.
+		 */
+		struct payload
+		{
+			K key;
+			T element;
+		};
+
+		typedef std::uint64_t word;
+
+		enum { kWords = (sizeof(payload) + sizeof(word) - 1) / sizeof(word) };
+
+		/**
+		 * One slot. The payload is kept in atomic words, so a reader copying it
+		 * while a writer changes it is a retry and not a data race.
+		 */
+		struct slot
+		{
+			std::atomic<std::uint32_t> version{ 0 };
+			std::atomic<entry_type> type{ kEmpty };
+			std::atomic<word> words[kWords]{};
+		};
+
+		/**
+		 * One published array of slots. Tombstones are only counted by writers.
+		 */
+		struct slot_table
+		{
+			explicit slot_table(const std::size_t slot_count)
+				: size(slot_count), slots(new slot[slot_count]) { }
+
+			std::size_t size;
+			std::unique_ptr<slot[]> slots;
+			std::size_t deleted_size{};
+		};
+
+		/**
+		 * The readers in flight on one stripe, split by the parity of the epoch they entered in.
+		 */
+		struct alignas(kCacheLine) reader_stripe
+		{
+			std::atomic<std::size_t> active[2]{};
+		};
+
+		/**
+		 * The array readers probe, swapped by writers when growing.
+		 */
+		std::atomic<slot_table *> current{};
+
+		/**
+		 * Flipped by writers to start a grace period, readers enter under its parity.
+		 */
+		std::atomic<std::size_t> epoch{};
+
+		mutable reader_stripe stripes[kStripes];
+
+		/**
+		 * Serializes the writers.
+		 */
+		std::mutex writer;
+
+		std::atomic<std::size_t> current_size{};
+
+		Hash hasher;
+
+		KeyEqual key_equal;
+
+		/**
+		 * Marks a reader as in flight on the stripe of its thread for as long as it lives.
+		 */
+		class read_guard
+		{
+		public:
+			explicit read_guard(const read_mostly_hash_table & owner)
+				: stripe(owner.stripes[stripe_of_thread()])
+			{
+				while (true)
+				{
+					this->parity = owner.epoch.load(std::memory_order_seq_cst) & 1;
+					this->stripe.active[this->parity].fetch_add(1, std::memory_order_seq_cst);
+					if ((owner.epoch.load(std::memory_order_seq_cst) & 1) == this->parity)
+					{ // entered before any flip, a writer flipping now will wait for us.
+						return;
+					} // else, a writer flipped the epoch in between, enter again, do_nothing();
+					this->stripe.active[this->parity].fetch_sub(1, std::memory_order_release);
+				}
+			}
+
+			~read_guard()
+			{
+				this->stripe.active[this->parity].fetch_sub(1, std::memory_order_release);
+			}
+
+			read_guard(const read_guard &) = delete;
+
+			read_guard & operator=(const read_guard &) = delete;
+
+		private:
+			reader_stripe & stripe;
+			std::size_t parity{};
+		};
+
+		/**
+		 * The reader stripe of the calling thread, handed out once per thread in
+		 * turn, so the first kStripes threads each get a stripe of their own.
+		 * Hashing the thread id instead would put two of a few threads on one
+		 * stripe more often than not.
+		 */
+		static std::size_t stripe_of_thread()
+		{
+			static std::atomic<std::size_t> next_stripe{};
+			thread_local const std::size_t index = next_stripe.fetch_add(1, std::memory_order_relaxed) % kStripes;
+			return index;
+		}
+
+		/**
+		 * Spin hint for a reader waiting on a writer.
+		 */
+		static void pause()
+		{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#else
+			std::this_thread::yield();
+#endif
+		}
+
+		/**
+		 * The number of used slots an array of the given size may hold, one half
+		 * like the hash_table, always leaving an empty slot to end probes.
+		 */
+		static std::size_t threshold_for(const std::size_t size)
+		{
+			return std::min(size / 2, size - 1);
+		}
+
+		std::size_t used(const slot_table & table) const
+		{
+			return this->current_size.load(std::memory_order_relaxed) + table.deleted_size;
+		}
+
+		/**
+		 * Copy the payload out of a slot, only valid under the writer lock.
+		 */
+		static payload load_payload(const slot & place)
+		{
+			word copy[kWords];
+			for (std::size_t i = 0; i < kWords; i++)
+			{
+				copy[i] = place.words[i].load(std::memory_order_relaxed);
+			}
+			payload result;
+			std::memcpy(&result, copy, sizeof(payload));
+			return result;
+		}
+
+		/**
+		 * Change a slot under its sequence lock.
+		 * @param place the slot being written.
+		 * @param type the new type of the slot.
+		 * @param value the new payload of the slot.
+		 */
+		static void write_slot(slot & place, const entry_type type, const payload & value)
+		{
+			word copy[kWords] = {};
+			std::memcpy(copy, &value, sizeof(payload));
+
+			const auto version = place.version.load(std::memory_order_relaxed);
+			place.version.store(version + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			place.type.store(type, std::memory_order_relaxed);
+			for (std::size_t i = 0; i < kWords; i++)
+			{
+				place.words[i].store(copy[i], std::memory_order_relaxed);
+			}
+			place.version.store(version + 2, std::memory_order_release);
+		}
+
+		/**
+		 * Copy a slot under its sequence lock, retrying while a writer is on it.
+		 * @param place the slot being read.
+		 * @param value set to the payload when the slot is active.
+		 * @return the type of the slot.
+		 */
+		static entry_type read_slot(const slot & place, payload & value)
+		{
+			while (true)
+			{
+				const auto version = place.version.load(std::memory_order_acquire);
+				if ((version & 1) == 0)
+				{
+					const auto type = place.type.load(std::memory_order_relaxed);
+					word copy[kWords];
+					if (type == kActive)
+					{
+						for (std::size_t i = 0; i < kWords; i++)
+						{
+							copy[i] = place.words[i].load(std::memory_order_relaxed);
+						}
+					} // else, only the type is needed, do_nothing();
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (place.version.load(std::memory_order_relaxed) == version)
+					{
+						if (type == kActive)
+						{
+							std::memcpy(&value, copy, sizeof(payload));
+						} // else, there is no payload, do_nothing();
+						return type;
+					} // else, a writer got in, read the slot again, do_nothing();
+				} // else, a writer is on the slot, do_nothing();
+				pause();
+			}
+		}
+
+		/**
+		 * The lock free lookup: probe the published array, copying each slot out
+		 * under its sequence lock, the array is kept alive by the read_guard.
+		 * @param key the key being searched for.
+		 * @param found set to the payload of the key when it is found.
+		 * @return true if the key was found.
+		 */
+		bool read(const K & key, payload & found) const
+		{
+			const read_guard guard(*this);
+			const auto table = this->current.load(std::memory_order_seq_cst);
+			std::size_t off_set = 1;
+			auto current_position = Policy::index(this->hasher(key), table->size);
+			while (true)
+			{
+				const auto type = read_slot(table->slots[current_position], found);
+				if (type == kEmpty)
+				{
+					return false;
+				} // else, the probe sequence goes on, do_nothing();
+				if (type == kActive && this->key_equal(found.key, key))
+				{
+					return true;
+				} // else, a different key or a tombstone, do_nothing();
+				current_position = Policy::probe(current_position, off_set, table->size);
+			}
+		}
+
+		/**
+		 * Find the slot of the key, or the slot a new entry for the key should go in,
+		 * reusing the first tombstone. Only called under the writer lock.
+		 */
+		std::size_t find_insert_position(const slot_table & table, const std::size_t code, const K & key) const
+		{
+			std::size_t off_set = 1;
+			auto current_position = Policy::index(code, table.size);
+			auto first_deleted = table.size;
+
+			while (true)
+			{
+				const auto & place = table.slots[current_position];
+				const auto type = place.type.load(std::memory_order_relaxed);
+				if (type == kEmpty)
+				{
+					return first_deleted == table.size ? current_position : first_deleted;
+				}
+				else if (type == kActive)
+				{
+					if (this->key_equal(load_payload(place).key, key))
+					{
+						return current_position;
+					} // else, a different key, do_nothing();
+				}
+				else if (first_deleted == table.size)
+				{
+					first_deleted = current_position;
+				} // else, an earlier tombstone was already seen, do_nothing();
+				current_position = Policy::probe(current_position, off_set, table.size);
+			}
+		}
+
+		/**
+		 * Copy every entry into a new array, doubled unless tombstones are what took
+		 * the array past the load factor, then publish it. Only called under the writer lock.
+		 * @return the new array.
+		 */
+		slot_table * grow(const slot_table & table)
+		{
+			const auto count = this->current_size.load(std::memory_order_relaxed);
+			const auto new_size = count * 2 <= threshold_for(table.size)
+				? table.size
+				: Policy::next_size(2 * table.size);
+			auto fresh = new slot_table(new_size);
+			for (std::size_t i = 0; i < table.size; i++)
+			{
+				if (table.slots[i].type.load(std::memory_order_relaxed) == kActive)
+				{
+					const auto value = load_payload(table.slots[i]);
+					std::size_t off_set = 1;
+					auto current_position = Policy::index(this->hasher(value.key), new_size);
+					while (fresh->slots[current_position].type.load(std::memory_order_relaxed) != kEmpty)
+					{
+						current_position = Policy::probe(current_position, off_set, new_size);
+					}
+					write_slot(fresh->slots[current_position], kActive, value);
+				} // else, the slot is not active, do_nothing();
+			}
+			this->publish(fresh);
+			return fresh;
+		}
+
+		/**
+		 * Swap in a new array, wait for the readers that may still see the old one, then free it.
+		 */
+		void publish(slot_table * fresh)
+		{
+			const auto old = this->current.exchange(fresh, std::memory_order_seq_cst);
+			this->wait_for_readers();
+			delete old;
+		}
+
+		/**
+		 * The grace period. Flip the epoch so new readers count themselves under
+		 * the other parity, then wait for every reader counted under the old one.
+		 * A reader entering under the old parity after the flip sees the flip and
+		 * enters again, so every reader left to wait for loaded the array before
+		 * the swap, and will leave soon.
+		 */
+		void wait_for_readers()
+		{
+			const auto parity = this->epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+			for (auto & stripe : this->stripes)
+			{
+				while (stripe.active[parity].load(std::memory_order_seq_cst) != 0)
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,501 @@
+#ifndef SMALL_HASH_TABLE_H_
+#define SMALL_HASH_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hash_table.h"
+
+namespace nwacc {
+
+	/**
+	 * A hash_table that keeps up to N entries inline in the object, without
+	 * any allocation or hashing, and moves them into a hash_table the first
+	 * time a new key does not fit. While small, a key is found by comparing it
+	 * against every inline key. For arithmetic and enum keys the compare is a
+	 * branchless loop over all N keys that the compiler turns into SIMD compares.
+	 * The hash_table is held through a pointer, so while small the object is
+	 * just the inline entries, their count, and one null pointer.
+	 * Emptying the table returns it to the inline storage.
+	 * @tparam N the number of inline entries, 1 to 64.
+	 */
+	template <typename T, typename K, std::size_t N = 8,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename Policy = power_of_two_policy,
+		typename Allocator = std::allocator<T>>
+	class small_hash_table
+	{
+	public:
+		typedef hash_table<T, K, Hash, KeyEqual, Policy, Allocator> table_type;
+
+		/**
+		 * Create an empty small_hash_table, nothing is allocated.
+		 */
+		explicit small_hash_table(const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual(),
+			const Allocator & allocator = Allocator())
+			: hasher(hash), key_equal(equal), allocator(allocator)
+		{
+			this->start_keys();
+		}
+
+		small_hash_table(const small_hash_table & rhs)
+			: table(rhs.table ? std::make_unique<table_type>(*rhs.table) : nullptr), hasher(rhs.hasher), key_equal(rhs.key_equal), allocator(rhs.allocator)
+		{
+			this->start_keys();
+			for (std::size_t i = 0; i < rhs.count; i++)
+			{
+				this->push(rhs.key_at(i), rhs.value_at(i));
+			}
+		}
+
+		small_hash_table(small_hash_table && rhs) noexcept(std::is_nothrow_move_constructible<T>::value &&
+			std::is_nothrow_move_constructible<K>::value)
+			: table(std::move(rhs.table)), hasher(rhs.hasher), key_equal(rhs.key_equal), allocator(rhs.allocator)
+		{
+			this->start_keys();
+			for (std::size_t i = 0; i < rhs.count; i++)
+			{
+				this->push(std::move(rhs.key_at(i)), std::move(rhs.value_at(i)));
+			}
+			rhs.clear_inline();
+		}
+
+		small_hash_table & operator=(const small_hash_table & rhs)
+		{
+			if (this != &rhs)
+			{
+				*this = small_hash_table(rhs);
+			} // else, it is the same table, do_nothing();
+			return *this;
+		}
+
+		small_hash_table & operator=(small_hash_table && rhs) noexcept(std::is_nothrow_move_constructible<T>::value &&
+			std::is_nothrow_move_constructible<K>::value)
+		{
+			if (this != &rhs)
+			{
+				this->clear_inline();
+				this->table = std::move(rhs.table);
+				for (std::size_t i = 0; i < rhs.count; i++)
+				{
+					this->push(std::move(rhs.key_at(i)), std::move(rhs.value_at(i)));
+				}
+				rhs.clear_inline();
+				this->hasher = rhs.hasher;
+				this->key_equal = rhs.key_equal;
+			} // else, it is the same table, do_nothing();
+			return *this;
+		}
+
+		~small_hash_table()
+		{
+			this->clear_inline();
+		}
+
+		/**
+		 * Determine if the entries are still inline, rather than in a hash_table.
+		 */
+		bool is_small() const
+		{
+			return this->table == nullptr;
+		}
+
+		/**
+		 * Determine if the small_hash_table contains an entry with a matching key.
+		 */
+		bool contains(const K & key) const
+		{
+			return this->find(key) != nullptr;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const K & key)
+		{
+			if (this->table)
+			{
+				return this->table->find(key);
+			} // else, the entries are inline, do_nothing();
+			const auto position = this->scan(key);
+			return position == N ? nullptr : &this->value_at(position);
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const K & key) const
+		{
+			if (this->table)
+			{ // the const find of the hash_table, which marks nothing as used or dirty.
+				return static_cast<const table_type &>(*this->table).find(key);
+			} // else, the entries are inline, do_nothing();
+			const auto position = this->scan(key);
+			return position == N ? nullptr : &this->value_at(position);
+		}
+
+		/**
+		 * Insert the value under the key, moving every entry into a hash_table when
+		 * the key is new and the inline storage is full.
+		 * If the key is already in the small_hash_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the small_hash_table.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			return this->insert_entry(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics, see insert.
+		 */
+		bool insert(T && value, K && key)
+		{
+			return this->insert_entry(std::move(value), std::move(key));
+		}
+
+		/**
+		 * Removes the entry of the key. An inline entry is replaced by the last
+		 * inline entry, so the inline entries stay packed at the front.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the small_hash_table.
+		 */
+		bool remove(const K & key)
+		{
+			if (this->table)
+			{
+				return this->table->remove(key);
+			} // else, the entries are inline, do_nothing();
+
+			const auto position = this->scan(key);
+			if (position == N)
+			{
+				return false;
+			} // else, the key is inline, do_nothing();
+
+			const auto last = this->count - 1;
+			if (position != last)
+			{
+				this->key_at(position) = std::move(this->key_at(last));
+				this->value_at(position) = std::move(this->value_at(last));
+			} // else, the entry is already last, do_nothing();
+			this->pop();
+			return true;
+		}
+
+		/**
+		 * Remove every entry and go back to the inline storage.
+		 */
+		void make_empty()
+		{
+			this->clear_inline();
+			this->table.reset();
+		}
+
+		/**
+		 * The number of entries.
+		 */
+		std::size_t size() const
+		{
+			return this->table ? this->table->size() : this->count;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the small_hash_table throw a length error.
+		 */
+		T & get_key(const K & key)
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the small_hash_table throw a length error.
+		 */
+		const T & get_key(const K & key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * The value stored under the key, inserting a default value when the key is missing.
+		 */
+		T & operator[](const K & key)
+		{
+			auto found = this->find(key);
+			if (found != nullptr)
+			{
+				return *found;
+			} // else, the key is new, do_nothing();
+			this->insert_entry(T(), key);
+			return *this->find(key);
+		}
+
+		/**
+		 * Call the function on every entry.
+		 * @param function called as function(const K & key, T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function)
+		{
+			if (this->table)
+			{
+				this->table->for_each_active(function);
+				return;
+			} // else, the entries are inline, do_nothing();
+			for (std::size_t i = 0; i < this->count; i++)
+			{
+				function(static_cast<const K &>(this->key_at(i)), this->value_at(i));
+			}
+		}
+
+		/**
+		 * Call the function on every entry.
+		 * @param function called as function(const K & key, const T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function) const
+		{
+			if (this->table)
+			{ // the const traversal of the hash_table, which marks no block dirty.
+				static_cast<const table_type &>(*this->table).for_each_active(function);
+				return;
+			} // else, the entries are inline, do_nothing();
+			for (std::size_t i = 0; i < this->count; i++)
+			{
+				function(this->key_at(i), this->value_at(i));
+			}
+		}
+
+	private:
+		static_assert(N > 0 && N <= 64, "small_hash_table keeps 1 to 64 inline entries");
+
+		/**
+		 * True when every inline key is always built, so a branchless compare can read
+		 * all N of them. std::equal_to on a number or enum is a plain ==.
+		 */
+		static constexpr bool kScanAll = (std::is_arithmetic<K>::value || std::is_enum<K>::value) &&
+			std::is_same<KeyEqual, std::equal_to<K>>::value;
+
+		/**
+		 * Find the inline position of the key.
+		 * @param key the key being searched for.
+		 * @return the position, or N when the key is not inline.
+		 */
+		std::size_t scan(const K & key) const
+		{
+			if constexpr (kScanAll)
+			{ // compare all N keys without branches, then keep the matches among the used slots.
+				std::uint64_t matches = 0;
+				for (std::size_t i = 0; i < N; i++)
+				{
+					matches |= static_cast<std::uint64_t>(this->key_at(i) == key) << i;
+				}
+				matches &= this->count == 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << this->count) - 1;
+				return matches == 0 ? N : count_trailing_zeros(matches);
+			}
+			else
+			{
+				for (std::size_t i = 0; i < this->count; i++)
+				{
+					if (this->key_equal(this->key_at(i), key))
+					{
+						return i;
+					} // else, a different key, do_nothing();
+				}
+				return N;
+			}
+		}
+
+		/**
+		 * Insert or assign, see insert.
+		 */
+		template <typename V, typename Q>
+		bool insert_entry(V && value, Q && key)
+		{
+			if (!this->table)
+			{
+				const auto position = this->scan(key);
+				if (position != N)
+				{
+					this->value_at(position) = std::forward<V>(value);
+					return false;
+				} // else, the key is new, do_nothing();
+
+				if (this->count < N)
+				{
+					this->push(std::forward<Q>(key), std::forward<V>(value));
+					return true;
+				} // else, the inline storage is full, do_nothing();
+				this->spill();
+			} // else, the entries are already hashed, do_nothing();
+			return this->table->insert_or_assign(std::forward<Q>(key), std::forward<V>(value)).second;
+		}
+
+		/**
+		 * Move every inline entry into a new hash_table with room for twice as many.
+		 */
+		void spill()
+		{
+			table_type hashed(static_cast<int>(2 * N), this->hasher, this->key_equal, this->allocator);
+			for (std::size_t i = 0; i < this->count; i++)
+			{
+				hashed.insert(std::move(this->value_at(i)), std::move(this->key_at(i)));
+			}
+			this->table = std::make_unique<table_type>(std::move(hashed));
+			this->clear_inline();
+		}
+
+		/**
+		 * Build the entry after the last inline one.
+		 */
+		template <typename Q, typename V>
+		void push(Q && key, V && value)
+		{
+			::new (static_cast<void *>(this->values() + this->count)) T(std::forward<V>(value));
+			if constexpr (kScanAll)
+			{
+				this->key_at(this->count) = std::forward<Q>(key);
+			}
+			else
+			{
+				try
+				{
+					::new (static_cast<void *>(this->keys() + this->count)) K(std::forward<Q>(key));
+				}
+				catch (...)
+				{
+					this->values()[this->count].~T();
+					throw;
+				}
+			}
+			++this->count;
+		}
+
+		/**
+		 * Destroy the last inline entry.
+		 */
+		void pop()
+		{
+			--this->count;
+			this->values()[this->count].~T();
+			if constexpr (!kScanAll)
+			{
+				this->keys()[this->count].~K();
+			} // else, the key stays built, do_nothing();
+		}
+
+		/**
+		 * Destroy every inline entry.
+		 */
+		void clear_inline()
+		{
+			while (this->count > 0)
+			{
+				this->pop();
+			}
+		}
+
+		/**
+		 * Build every inline key up front when they are all compared, as zeros.
+		 * They are trivially destructible, so pop leaves them built.
+		 */
+		void start_keys()
+		{
+			if constexpr (kScanAll)
+			{
+				for (std::size_t i = 0; i < N; i++)
+				{
+					::new (static_cast<void *>(this->keys() + i)) K();
+				}
+			} // else, the keys are built by push, do_nothing();
+		}
+
+		K * keys()
+		{
+			return std::launder(reinterpret_cast<K *>(this->key_storage));
+		}
+
+		const K * keys() const
+		{
+			return std::launder(reinterpret_cast<const K *>(this->key_storage));
+		}
+
+		T * values()
+		{
+			return std::launder(reinterpret_cast<T *>(this->value_storage));
+		}
+
+		const T * values() const
+		{
+			return std::launder(reinterpret_cast<const T *>(this->value_storage));
+		}
+
+		K & key_at(const std::size_t position)
+		{
+			return this->keys()[position];
+		}
+
+		const K & key_at(const std::size_t position) const
+		{
+			return this->keys()[position];
+		}
+
+		T & value_at(const std::size_t position)
+		{
+			return this->values()[position];
+		}
+
+		const T & value_at(const std::size_t position) const
+		{
+			return this->values()[position];
+		}
+
+		/**
+		 * The inline keys and values, kept apart so the keys are contiguous for the scan.
+		 */
+		alignas(K) unsigned char key_storage[N * sizeof(K)];
+		alignas(T) unsigned char value_storage[N * sizeof(T)];
+
+		/**
+		 * The number of inline entries, zero once the entries are hashed.
+		 */
+		std::size_t count{};
+
+		/**
+		 * The hash_table holding the entries once they no longer fit inline.
+		 */
+		std::unique_ptr<table_type> table;
+
+		Hash hasher;
+		KeyEqual key_equal;
+		Allocator allocator;
+	};
+}
+
+#endif
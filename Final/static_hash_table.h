@@ -0,0 +1,282 @@
+#ifndef STATIC_HASH_TABLE_H_
+#define STATIC_HASH_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "hash_policy.h"
+
+namespace nwacc {
+
+	/**
+	 * A hash that can run at compile time, for the keys of a static_hash_table.
+	 * Integers, enums, and std::string_view are supported, specialize it for
+	 * any other literal key type.
+	 */
+	template <typename K, typename = void>
+	struct static_hash;
+
+	template <typename K>
+	struct static_hash<K, typename std::enable_if<std::is_integral<K>::value || std::is_enum<K>::value>::type>
+	{
+		constexpr std::size_t operator()(const K key) const
+		{
+			return mix(static_cast<std::size_t>(key));
+		}
+	};
+
+	/**
+	 * FNV-1a over the characters, then mixed so every bit of the code depends on every character.
+	 */
+	template <>
+	struct static_hash<std::string_view>
+	{
+		constexpr std::size_t operator()(const std::string_view key) const
+		{
+			std::uint64_t hash = 0xcbf29ce484222325ULL;
+			for (const auto character : key)
+			{
+				hash ^= static_cast<unsigned char>(character);
+				hash *= 0x100000001b3ULL;
+			}
+			return mix(static_cast<std::size_t>(hash));
+		}
+	};
+
+	/**
+	 * An immutable hash table of N values T stored under keys K, built entirely
+	 * at compile time, for lookup tables such as command names or protocol
+	 * opcodes. Declared constexpr it lives in read only data, with nothing
+	 * to build at startup and nothing allocated.
+	 * The keys are placed with a perfect hash, the hash and displace scheme of
+	 * Belazzougui, Botelho, and Dietzfelbinger: the keys are split into small
+	 * buckets by their hash code, and every bucket gets a seed that sends all
+	 * of its keys to free slots. A lookup hashes the key once, reads the seed
+	 * of its bucket, and checks a single slot.
+	 * Build one with make_static_hash_table, for example
+	 * constexpr auto opcodes = make_static_hash_table<int, std::string_view>({ { "add", 1 }, { "sub", 2 } });
+	 * @tparam Hash the function object hashing a key, which must be constexpr.
+	 * @tparam KeyEqual the function object comparing two keys, which must be constexpr.
+	 */
+	template <typename T, typename K, std::size_t N,
+		typename Hash = static_hash<K>,
+		typename KeyEqual = std::equal_to<K>>
+	class static_hash_table
+	{
+		static_assert(N > 0, "a static_hash_table needs at least one entry");
+
+	public:
+		/**
+		 * The number of slots, a prime giving a load factor of about 0.8.
+		 */
+		static constexpr std::size_t kCapacity = prime_policy::next_prime(N + N / 4 + 1);
+
+		/**
+		 * The number of buckets sharing a seed, about two keys a bucket.
+		 */
+		static constexpr std::size_t kBuckets = N / 2 + 1;
+
+		/**
+		 * Place the entries. Run at compile time, a duplicate key, or keys that
+		 * no seed can separate, fail the build through the thrown exception.
+		 * @param entries the keys in first and their values in second.
+		 * @throws std::invalid_argument if two keys are equal or can not be placed.
+		 */
+		constexpr explicit static_hash_table(const std::pair<K, T>(&entries)[N],
+			const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual())
+			: hasher(hash), key_equal(equal)
+		{
+			std::size_t codes[N]{};
+			std::size_t starts[kBuckets + 1]{};
+			for (std::size_t i = 0; i < N; i++)
+			{
+				codes[i] = this->hasher(entries[i].first);
+				++starts[codes[i] % kBuckets + 1];
+			}
+			for (std::size_t i = 0; i < kBuckets; i++)
+			{
+				starts[i + 1] += starts[i];
+			}
+
+			// group the entries by bucket, members[starts[b]] to members[starts[b + 1]] are bucket b.
+			std::size_t members[N]{};
+			std::size_t filled[kBuckets]{};
+			for (std::size_t i = 0; i < N; i++)
+			{
+				const auto bucket = codes[i] % kBuckets;
+				members[starts[bucket] + filled[bucket]++] = i;
+			}
+
+			// the biggest buckets are seeded first, while most slots are still free.
+			std::size_t order[kBuckets]{};
+			for (std::size_t i = 0; i < kBuckets; i++)
+			{
+				auto j = i;
+				for (; j > 0 && filled[order[j - 1]] < filled[i]; j--)
+				{
+					order[j] = order[j - 1];
+				}
+				order[j] = i;
+			}
+
+			for (std::size_t i = 0; i < kBuckets && filled[order[i]] > 0; i++)
+			{
+				const auto bucket = order[i];
+				const auto first = starts[bucket];
+				const auto last = starts[bucket + 1];
+				for (auto a = first; a < last; a++)
+				{
+					for (auto b = a + 1; b < last; b++)
+					{
+						if (codes[members[a]] == codes[members[b]])
+						{ // no seed tells two equal codes apart.
+							throw std::invalid_argument("Duplicate or colliding keys in a static_hash_table....");
+						} // else, the codes differ, do_nothing();
+					}
+				}
+
+				std::uint32_t seed = 0;
+				while (!this->try_seed(codes, members, first, last, seed))
+				{
+					if (++seed == kMaxSeed)
+					{
+						throw std::invalid_argument("Could not place the keys of a static_hash_table....");
+					} // else, try the next seed, do_nothing();
+				}
+				this->seeds[bucket] = seed;
+				for (auto member = first; member < last; member++)
+				{
+					const auto position = slot_of(codes[members[member]], seed);
+					this->keys[position] = entries[members[member]].first;
+					this->values[position] = entries[members[member]].second;
+					this->occupied[position] = true;
+				}
+			}
+		}
+
+		/**
+		 * Determine if the static_hash_table contains an entry with a matching key.
+		 */
+		constexpr bool contains(const K & key) const
+		{
+			return this->find(key) != nullptr;
+		}
+
+		/**
+		 * Find the value stored under the key, checking one slot.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		constexpr const T * find(const K & key) const
+		{
+			const auto code = this->hasher(key);
+			const auto position = slot_of(code, this->seeds[code % kBuckets]);
+			return this->occupied[position] && this->key_equal(this->keys[position], key) ?
+				&this->values[position] : nullptr;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the static_hash_table throw a length error.
+		 */
+		constexpr const T & get_key(const K & key) const
+		{
+			const auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * The number of entries.
+		 */
+		constexpr std::size_t size() const
+		{
+			return N;
+		}
+
+		/**
+		 * Call the function on every entry.
+		 * @param function called as function(const K & key, const T & value).
+		 */
+		template <typename Function>
+		constexpr void for_each_active(Function function) const
+		{
+			for (std::size_t i = 0; i < kCapacity; i++)
+			{
+				if (this->occupied[i])
+				{
+					function(this->keys[i], this->values[i]);
+				} // else, the slot holds no entry, do_nothing();
+			}
+		}
+
+	private:
+		/**
+		 * The seeds tried for a bucket before giving up.
+		 */
+		static constexpr std::uint32_t kMaxSeed = 1u << 20;
+
+		/**
+		 * The slot of a hash code under the seed of its bucket.
+		 */
+		static constexpr std::size_t slot_of(const std::size_t code, const std::uint32_t seed)
+		{
+			return mix(code + seed * static_cast<std::size_t>(0x9e3779b97f4a7c15ULL)) % kCapacity;
+		}
+
+		/**
+		 * Determine if a seed sends every key of a bucket to a different free slot.
+		 */
+		constexpr bool try_seed(const std::size_t(&codes)[N], const std::size_t(&members)[N],
+			const std::size_t first, const std::size_t last, const std::uint32_t seed) const
+		{
+			for (auto a = first; a < last; a++)
+			{
+				const auto position = slot_of(codes[members[a]], seed);
+				if (this->occupied[position])
+				{
+					return false;
+				} // else, the slot is free, do_nothing();
+				for (auto b = first; b < a; b++)
+				{
+					if (slot_of(codes[members[b]], seed) == position)
+					{
+						return false;
+					} // else, the keys of the bucket land apart, do_nothing();
+				}
+			}
+			return true;
+		}
+
+		K keys[kCapacity]{};
+		T values[kCapacity]{};
+		bool occupied[kCapacity]{};
+		std::uint32_t seeds[kBuckets]{};
+
+		Hash hasher;
+		KeyEqual key_equal;
+	};
+
+	/**
+	 * Build a static_hash_table from a braced list of key and value pairs, the
+	 * number of entries is taken from the list.
+	 * @param entries the keys in first and their values in second.
+	 * @return the static_hash_table, constexpr when the call is.
+	 */
+	template <typename T, typename K, typename Hash = static_hash<K>, typename KeyEqual = std::equal_to<K>,
+		std::size_t N>
+	constexpr static_hash_table<T, K, N, Hash, KeyEqual> make_static_hash_table(const std::pair<K, T>(&entries)[N])
+	{
+		return static_hash_table<T, K, N, Hash, KeyEqual>(entries);
+	}
+}
+
+#endif
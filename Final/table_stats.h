@@ -0,0 +1,248 @@
+#ifndef TABLE_STATS_H_
+#define TABLE_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace nwacc {
+
+	/**
+	 * A snapshot of how a hash_table is doing, returned by hash_table::stats.
+	 * The size, capacity, tombstones, and load factor are always filled in.
+	 * The probe histograms and the rehash counters are only recorded when the
+	 * hash_table is compiled with NWACC_HASH_TABLE_STATS defined, and are zero
+	 * otherwise, see enabled.
+	 */
+	struct table_stats
+	{
+		/**
+		 * The number of buckets of a probe histogram. Bucket i counts the probe
+		 * sequences that checked from 2^i to 2^(i+1) - 1 slots, the last bucket
+		 * also counts every longer one.
+		 */
+		enum { kHistogramSize = 16 };
+
+		/**
+		 * True when the probe histograms and rehash counters are recorded.
+		 */
+		bool enabled{};
+
+		std::size_t size{};
+		std::size_t capacity{};
+		std::size_t tombstones{};
+		float load_factor{};
+
+		/**
+		 * The number of slots checked by lookups that found their key.
+		 */
+		std::uint64_t hit_probes[kHistogramSize]{};
+
+		/**
+		 * The number of slots checked by lookups that did not find their key.
+		 */
+		std::uint64_t miss_probes[kHistogramSize]{};
+
+		/**
+		 * The number of slots checked to find the slot of a new entry.
+		 */
+		std::uint64_t insert_probes[kHistogramSize]{};
+
+		/**
+		 * The longest probe sequence seen by any lookup or insert.
+		 */
+		std::size_t max_probe{};
+
+		/**
+		 * The number of times the array was rebuilt, to grow or to drop tombstones.
+		 */
+		std::uint64_t rehash_count{};
+
+		/**
+		 * The time spent moving entries into rebuilt arrays, incremental moves included.
+		 */
+		std::chrono::nanoseconds rehash_time{};
+
+		/**
+		 * The histogram bucket of a probe sequence.
+		 * @param probes the number of slots checked, at least 1.
+		 * @return the bucket counting it.
+		 */
+		static std::size_t bucket_of(std::size_t probes)
+		{
+			std::size_t bucket = 0;
+			while (probes > 1 && bucket + 1 < kHistogramSize)
+			{
+				probes >>= 1;
+				++bucket;
+			}
+			return bucket;
+		}
+	};
+
+#if defined(NWACC_HASH_TABLE_STATS)
+	/**
+	 * Counts the slots checked by one probe sequence.
+	 */
+	class probe_counter
+	{
+	public:
+		void add()
+		{
+			++this->probes;
+		}
+
+		std::size_t count() const
+		{
+			return this->probes;
+		}
+
+	private:
+		std::size_t probes{ 1 };
+	};
+
+	/**
+	 * The counters behind table_stats. They are relaxed atomics, so the const
+	 * lookups of readers sharing a hash_table, such as those of a
+	 * concurrent_hash_table under a shared lock, can record at the same time.
+	 */
+	class stats_recorder
+	{
+	public:
+		stats_recorder() = default;
+
+		stats_recorder(const stats_recorder & rhs)
+		{
+			this->copy(rhs);
+		}
+
+		stats_recorder & operator=(const stats_recorder & rhs)
+		{
+			this->copy(rhs);
+			return *this;
+		}
+
+		void record_hit(const probe_counter & probes)
+		{
+			this->record(this->hit_probes, probes);
+		}
+
+		void record_miss(const probe_counter & probes)
+		{
+			this->record(this->miss_probes, probes);
+		}
+
+		void record_insert(const probe_counter & probes)
+		{
+			this->record(this->insert_probes, probes);
+		}
+
+		void record_rehash()
+		{
+			this->rehash_count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Add the time since start to the time spent rehashing.
+		 */
+		void record_rehash_time(const std::chrono::steady_clock::time_point start)
+		{
+			const auto spent = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start);
+			this->rehash_nanoseconds.fetch_add(static_cast<std::uint64_t>(spent.count()), std::memory_order_relaxed);
+		}
+
+		/**
+		 * Fill in the recorded part of a table_stats.
+		 */
+		void fill(table_stats & stats) const
+		{
+			stats.enabled = true;
+			for (std::size_t i = 0; i < table_stats::kHistogramSize; i++)
+			{
+				stats.hit_probes[i] = this->hit_probes[i].load(std::memory_order_relaxed);
+				stats.miss_probes[i] = this->miss_probes[i].load(std::memory_order_relaxed);
+				stats.insert_probes[i] = this->insert_probes[i].load(std::memory_order_relaxed);
+			}
+			stats.max_probe = this->max_probe.load(std::memory_order_relaxed);
+			stats.rehash_count = this->rehash_count.load(std::memory_order_relaxed);
+			stats.rehash_time = std::chrono::nanoseconds(
+				static_cast<std::chrono::nanoseconds::rep>(this->rehash_nanoseconds.load(std::memory_order_relaxed)));
+		}
+
+		/**
+		 * Start the time of a rehash.
+		 */
+		static std::chrono::steady_clock::time_point now()
+		{
+			return std::chrono::steady_clock::now();
+		}
+
+	private:
+		typedef std::atomic<std::uint64_t> histogram[table_stats::kHistogramSize];
+
+		void record(histogram & counts, const probe_counter & probes)
+		{
+			counts[table_stats::bucket_of(probes.count())].fetch_add(1, std::memory_order_relaxed);
+			auto longest = this->max_probe.load(std::memory_order_relaxed);
+			while (probes.count() > longest &&
+				!this->max_probe.compare_exchange_weak(longest, probes.count(), std::memory_order_relaxed))
+			{ // another reader raised the maximum, check against its value.
+			}
+		}
+
+		void copy(const stats_recorder & rhs)
+		{
+			for (std::size_t i = 0; i < table_stats::kHistogramSize; i++)
+			{
+				this->hit_probes[i].store(rhs.hit_probes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				this->miss_probes[i].store(rhs.miss_probes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				this->insert_probes[i].store(rhs.insert_probes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+			this->max_probe.store(rhs.max_probe.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			this->rehash_count.store(rhs.rehash_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			this->rehash_nanoseconds.store(rhs.rehash_nanoseconds.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+		histogram hit_probes{};
+		histogram miss_probes{};
+		histogram insert_probes{};
+		std::atomic<std::size_t> max_probe{};
+		std::atomic<std::uint64_t> rehash_count{};
+		std::atomic<std::uint64_t> rehash_nanoseconds{};
+	};
+#else
+	/**
+	 * Stands in for the probe counter when stats are compiled out, every call is a no-op.
+	 */
+	class probe_counter
+	{
+	public:
+		void add() { }
+	};
+
+	/**
+	 * Stands in for the stats counters when stats are compiled out, every call is a no-op.
+	 */
+	class stats_recorder
+	{
+	public:
+		struct time_point { };
+
+		void record_hit(const probe_counter &) { }
+		void record_miss(const probe_counter &) { }
+		void record_insert(const probe_counter &) { }
+		void record_rehash() { }
+		void record_rehash_time(const time_point) { }
+		void fill(table_stats &) const { }
+
+		static time_point now()
+		{
+			return time_point();
+		}
+	};
+#endif
+}
+
+#endif
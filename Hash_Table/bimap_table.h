@@ -0,0 +1,465 @@
+#ifndef BIMAP_TABLE_H_
+#define BIMAP_TABLE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "hash_policy.h"
+
+namespace nwacc {
+
+	/**
+	 * A one to one map between keys K and values T, hashed in both directions,
+	 * for interning such as ids to names. Every entry is kept once, in a dense
+	 * array, and two compact arrays of 32 bit entry offsets index it, one
+	 * hashed by key and one hashed by value. A lookup in either direction is a
+	 * single hashed probe, with no value kept twice. Both the keys and the
+	 * values are unique, so an insert clashing with either is refused.
+	 * Removing an entry moves the last entry into its place, keeping the
+	 * entries dense. The index arrays use linear probing on a power of two
+	 * size, with tombstones, and are rebuilt from the entries when growing.
+	 * Mirrors the hash_table interface, get_key finds the value of a key and
+	 * get_value finds the key of a value.
+	 */
+	template <typename T, typename K,
+		typename KeyHash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename ValueHash = std::hash<T>,
+		typename ValueEqual = std::equal_to<T>>
+	class bimap_table
+	{
+	public:
+		/**
+		 * Create a new bimap_table with room for at least the given number of entries.
+		 * @param size the number of entries to make room for.
+		 */
+		explicit bimap_table(const std::size_t size = 8, const KeyHash & key_hash = KeyHash(),
+			const KeyEqual & key_equal = KeyEqual(), const ValueHash & value_hash = ValueHash(),
+			const ValueEqual & value_equal = ValueEqual())
+			: key_hasher(key_hash), key_equal(key_equal), value_hasher(value_hash), value_equal(value_equal)
+		{
+			this->rebuild(this->capacity_for(size));
+		}
+
+		/**
+		 * Determine if the bimap_table contains an entry with a matching key.
+		 */
+		bool contains(const K & key) const
+		{
+			return this->find_slot<false>(key) != kMissing;
+		}
+
+		/**
+		 * Determine if the bimap_table contains an entry with a matching value.
+		 */
+		bool contains_value(const T & value) const
+		{
+			return this->find_slot<true>(value) != kMissing;
+		}
+
+		/**
+		 * Find the value stored under the key. The value can not be changed in place,
+		 * since it is indexed.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const K & key) const
+		{
+			const auto offset = this->find_offset<false>(key);
+			return offset == kMissing ? nullptr : &this->entries[offset].element;
+		}
+
+		/**
+		 * Find the key of the entry holding the value.
+		 * @param value the value being searched for.
+		 * @return a pointer to the key, or nullptr when the value is missing.
+		 */
+		const K * find_value(const T & value) const
+		{
+			const auto offset = this->find_offset<true>(value);
+			return offset == kMissing ? nullptr : &this->entries[offset].key;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the bimap_table throw a length error.
+		 */
+		const T & get_key(const K & key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the key of the entry holding the value.
+		 * If the value does not exist in the bimap_table throw a length error.
+		 */
+		const K & get_value(const T & value) const
+		{
+			auto found = this->find_value(value);
+			if (found == nullptr)
+			{
+				throw std::length_error("Value not found....");
+			} // else, value exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Insert the value under the key, unless either is already in the bimap_table.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key or the value was already in the bimap_table, nothing is changed.
+		 * @throws std::length_error if the bimap_table already holds the most entries a 32 bit offset reaches.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			return this->insert_entry(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics, see insert.
+		 */
+		bool insert(T && value, K && key)
+		{
+			return this->insert_entry(std::move(value), std::move(key));
+		}
+
+		/**
+		 * Removes the entry of the key.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the bimap_table.
+		 */
+		bool remove(const K & key)
+		{
+			const auto offset = this->find_offset<false>(key);
+			if (offset == kMissing)
+			{
+				return false;
+			} // else, the key is in the table, do_nothing();
+			this->erase_at(offset);
+			return true;
+		}
+
+		/**
+		 * Removes the entry holding the value.
+		 * @param value the value to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the value is not in the bimap_table.
+		 */
+		bool remove_value(const T & value)
+		{
+			const auto offset = this->find_offset<true>(value);
+			if (offset == kMissing)
+			{
+				return false;
+			} // else, the value is in the table, do_nothing();
+			this->erase_at(offset);
+			return true;
+		}
+
+		/**
+		 * Remove every entry, keeping the allocated index arrays.
+		 */
+		void make_empty()
+		{
+			this->entries.clear();
+			std::fill(this->key_index.begin(), this->key_index.end(), kEmpty);
+			std::fill(this->value_index.begin(), this->value_index.end(), kEmpty);
+			this->key_tombstones = 0;
+			this->value_tombstones = 0;
+		}
+
+		/**
+		 * Make room for the number of entries, so inserting them never rebuilds the index arrays.
+		 * @param count the number of entries to hold.
+		 */
+		void reserve(const std::size_t count)
+		{
+			this->entries.reserve(count);
+			const auto new_capacity = this->capacity_for(count);
+			if (new_capacity > this->key_index.size())
+			{
+				this->rebuild(new_capacity);
+			} // else, there is already room, do_nothing();
+		}
+
+		/**
+		 * The number of entries in the bimap_table.
+		 */
+		std::size_t size() const
+		{
+			return this->entries.size();
+		}
+
+		/**
+		 * Call the function on every entry, in the order of the dense entry array.
+		 * @param function called as function(const K & key, const T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function) const
+		{
+			for (const auto & current : this->entries)
+			{
+				function(current.key, current.element);
+			}
+		}
+
+	private:
+		/**
+		 * An entry of the dense array, pointed at by one slot of each index array.
+		 */
+		struct entry
+		{
+			T element;
+			K key;
+
+			template <typename V, typename Q>
+			entry(V && e, Q && k) : element(std::forward<V>(e)), key(std::forward<Q>(k)) { }
+		};
+
+		/**
+		 * An index slot that never pointed at an entry, and one whose entry was removed.
+		 */
+		static constexpr std::uint32_t kEmpty = 0xFFFFFFFFu;
+		static constexpr std::uint32_t kDeleted = 0xFFFFFFFEu;
+
+		/**
+		 * The most entries, every offset must stay below the reserved slot values.
+		 */
+		static constexpr std::size_t kMaxEntries = kDeleted;
+
+		/**
+		 * Returned by the finds when there is no match.
+		 */
+		static constexpr std::size_t kMissing = ~std::size_t{ 0 };
+
+		/**
+		 * The highest fraction of index slots holding offsets or tombstones.
+		 */
+		static constexpr double kMaxLoad = 0.75;
+
+		std::vector<entry> entries;
+
+		/**
+		 * The offsets of the entries, hashed by key and by value.
+		 */
+		std::vector<std::uint32_t> key_index;
+		std::vector<std::uint32_t> value_index;
+
+		std::size_t key_tombstones{};
+		std::size_t value_tombstones{};
+
+		KeyHash key_hasher;
+		KeyEqual key_equal;
+		ValueHash value_hasher;
+		ValueEqual value_equal;
+
+		/**
+		 * The index size holding the number of entries under the max load.
+		 */
+		static std::size_t capacity_for(const std::size_t count)
+		{
+			return power_of_two_policy::next_size(static_cast<std::size_t>(count / kMaxLoad) + 1);
+		}
+
+		/**
+		 * The number of offsets and tombstones an index of the given size holds.
+		 */
+		static std::size_t threshold_for(const std::size_t size)
+		{
+			return static_cast<std::size_t>(size * kMaxLoad);
+		}
+
+		/**
+		 * The index array hashed by value when ByValue is set, otherwise by key.
+		 */
+		template <bool ByValue>
+		std::vector<std::uint32_t> & index_of()
+		{
+			return ByValue ? this->value_index : this->key_index;
+		}
+
+		template <bool ByValue>
+		const std::vector<std::uint32_t> & index_of() const
+		{
+			return ByValue ? this->value_index : this->key_index;
+		}
+
+		/**
+		 * The home slot of a key, or of a value when ByValue is set.
+		 */
+		template <bool ByValue, typename Q>
+		std::size_t home(const Q & field) const
+		{
+			if constexpr (ByValue)
+			{
+				return power_of_two_policy::index(this->value_hasher(field), this->value_index.size());
+			}
+			else
+			{
+				return power_of_two_policy::index(this->key_hasher(field), this->key_index.size());
+			}
+		}
+
+		/**
+		 * Determine if an entry holds the key, or the value when ByValue is set.
+		 */
+		template <bool ByValue, typename Q>
+		bool holds(const entry & current, const Q & field) const
+		{
+			if constexpr (ByValue)
+			{
+				return this->value_equal(current.element, field);
+			}
+			else
+			{
+				return this->key_equal(current.key, field);
+			}
+		}
+
+		/**
+		 * Find the index slot pointing at the entry holding a key, or a value when ByValue is set.
+		 * @return the index slot, or kMissing.
+		 */
+		template <bool ByValue, typename Q>
+		std::size_t find_slot(const Q & field) const
+		{
+			const auto & index = this->index_of<ByValue>();
+			const auto mask = index.size() - 1;
+			for (auto position = this->home<ByValue>(field); index[position] != kEmpty; position = (position + 1) & mask)
+			{
+				if (index[position] != kDeleted && this->holds<ByValue>(this->entries[index[position]], field))
+				{
+					return position;
+				} // else, a different entry or a tombstone, do_nothing();
+			}
+			return kMissing;
+		}
+
+		/**
+		 * Find the offset of the entry holding a key, or a value when ByValue is set.
+		 * @return the offset, or kMissing.
+		 */
+		template <bool ByValue, typename Q>
+		std::size_t find_offset(const Q & field) const
+		{
+			const auto position = this->find_slot<ByValue>(field);
+			return position == kMissing ? kMissing : this->index_of<ByValue>()[position];
+		}
+
+		/**
+		 * Find the index slot pointing at an offset, comparing offsets only.
+		 */
+		template <bool ByValue>
+		std::size_t locate(const std::size_t offset) const
+		{
+			const auto & index = this->index_of<ByValue>();
+			const auto mask = index.size() - 1;
+			const auto & current = this->entries[offset];
+			auto position = ByValue ? this->home<true>(current.element) : this->home<false>(current.key);
+			while (index[position] != offset)
+			{
+				position = (position + 1) & mask;
+			}
+			return position;
+		}
+
+		/**
+		 * Point the first free slot of the probe sequence of an entry at it.
+		 */
+		template <bool ByValue>
+		void place(const std::size_t offset)
+		{
+			auto & index = this->index_of<ByValue>();
+			const auto mask = index.size() - 1;
+			const auto & current = this->entries[offset];
+			auto position = ByValue ? this->home<true>(current.element) : this->home<false>(current.key);
+			while (index[position] != kEmpty && index[position] != kDeleted)
+			{
+				position = (position + 1) & mask;
+			}
+			if (index[position] == kDeleted)
+			{
+				--(ByValue ? this->value_tombstones : this->key_tombstones);
+			} // else, an empty slot is taken, do_nothing();
+			index[position] = static_cast<std::uint32_t>(offset);
+		}
+
+		/**
+		 * Insert the entry unless its key or value is already in the bimap_table.
+		 */
+		template <typename V, typename Q>
+		bool insert_entry(V && value, Q && key)
+		{
+			if (this->find_slot<false>(key) != kMissing || this->find_slot<true>(value) != kMissing)
+			{
+				return false;
+			} // else, both are new, do_nothing();
+			if (this->entries.size() >= kMaxEntries)
+			{
+				throw std::length_error("Too many entries for a bimap_table....");
+			} // else, there is an offset left, do_nothing();
+
+			const auto used = this->entries.size() + 1 + std::max(this->key_tombstones, this->value_tombstones);
+			if (used > threshold_for(this->key_index.size()))
+			{ // grow unless the tombstones alone fill the index, then a rebuild of the same size drops them.
+				const auto size = this->key_index.size();
+				this->rebuild(this->entries.size() + 1 > threshold_for(size) / 2 ? size * 2 : size);
+			} // else we are within the load factor do_nothing();
+
+			this->entries.emplace_back(std::forward<V>(value), std::forward<Q>(key));
+			this->place<false>(this->entries.size() - 1);
+			this->place<true>(this->entries.size() - 1);
+			return true;
+		}
+
+		/**
+		 * Remove the entry at an offset, moving the last entry into its place.
+		 */
+		void erase_at(const std::size_t offset)
+		{
+			this->key_index[this->locate<false>(offset)] = kDeleted;
+			this->value_index[this->locate<true>(offset)] = kDeleted;
+			++this->key_tombstones;
+			++this->value_tombstones;
+
+			const auto last = this->entries.size() - 1;
+			if (offset != last)
+			{ // the index slots of the last entry follow it to its new offset.
+				this->key_index[this->locate<false>(last)] = static_cast<std::uint32_t>(offset);
+				this->value_index[this->locate<true>(last)] = static_cast<std::uint32_t>(offset);
+				this->entries[offset] = std::move(this->entries[last]);
+			} // else, the entry is already last, do_nothing();
+			this->entries.pop_back();
+		}
+
+		/**
+		 * Rebuild both index arrays with the given number of slots, dropping the tombstones.
+		 */
+		void rebuild(const std::size_t new_capacity)
+		{
+			this->key_index.assign(new_capacity, kEmpty);
+			this->value_index.assign(new_capacity, kEmpty);
+			this->key_tombstones = 0;
+			this->value_tombstones = 0;
+			for (std::size_t i = 0; i < this->entries.size(); i++)
+			{
+				this->place<false>(i);
+				this->place<true>(i);
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef CACHE_TABLE_H_
+#define CACHE_TABLE_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "hash_table.h"
+
+namespace nwacc {
+
+	/**
+	 * A cache of values T stored under keys K, holding at most a fixed number
+	 * of entries and evicting with the CLOCK algorithm once full. It is a
+	 * hash_table with the clock_policy, which keeps a reference byte next to
+	 * the type byte of every slot: a lookup finding an entry sets its byte,
+	 * with no list to update. To make room the clock hand walks the slots in
+	 * order, clearing the byte of every referenced entry it passes, and evicts
+	 * the first entry whose byte is already clear, through the same tombstone
+	 * path as remove. Every slot is allocated up front, with room for twice the
+	 * capacity in entries and tombstones, so the memory stays flat and the
+	 * tombstones are dropped by a rebuild at the same size, which also clears
+	 * every reference byte.
+	 * @tparam Hash the function object hashing a key.
+	 * @tparam KeyEqual the function object comparing two keys for equality.
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename Allocator = std::allocator<T>>
+	class cache_table
+	{
+	public:
+		typedef hash_table<T, K, Hash, KeyEqual, clock_policy, Allocator> table_type;
+
+		/**
+		 * Create an empty cache_table, allocating every slot it will use.
+		 * @param capacity the most entries held, greater than zero.
+		 * @throws std::invalid_argument if the capacity is zero.
+		 */
+		explicit cache_table(const std::size_t capacity, const Hash & hash = Hash(),
+			const KeyEqual & equal = KeyEqual(), const Allocator & allocator = Allocator())
+			: table(7, hash, equal, allocator), limit(capacity)
+		{
+			if (capacity == 0)
+			{
+				throw std::invalid_argument("A cache_table needs a capacity greater than zero....");
+			} // else, the capacity is valid, do_nothing();
+			this->table.max_load_factor(kMaxLoad);
+			this->table.reserve(2 * capacity);
+		}
+
+		/**
+		 * Determine if the cache_table holds the key. This does not count as a use
+		 * of the entry, so it does not protect it from eviction.
+		 */
+		bool contains(const K & key) const
+		{
+			return this->table.contains(key);
+		}
+
+		/**
+		 * Find the value stored under the key, marking the entry as used.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const K & key)
+		{
+			return this->table.find(key);
+		}
+
+		/**
+		 * Returns the value stored under the key, marking the entry as used.
+		 * If the key does not exist in the cache_table throw a length error.
+		 */
+		T & get_key(const K & key)
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Insert the value under the key, evicting another entry when the
+		 * cache_table was full and the key is new. If the key is already in the
+		 * cache_table its value is replaced and the entry marked as used.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the cache_table.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			return this->insert_entry(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics, see insert.
+		 */
+		bool insert(T && value, K && key)
+		{
+			return this->insert_entry(std::move(value), std::move(key));
+		}
+
+		/**
+		 * Removes the entry of the key.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the cache_table.
+		 */
+		bool remove(const K & key)
+		{
+			return this->table.remove(key);
+		}
+
+		/**
+		 * Remove every entry, keeping the allocated slots.
+		 */
+		void make_empty()
+		{
+			this->table.make_empty();
+			this->hand = 0;
+		}
+
+		/**
+		 * The number of entries.
+		 */
+		std::size_t size() const
+		{
+			return this->table.size();
+		}
+
+		/**
+		 * The most entries the cache_table holds before evicting.
+		 */
+		std::size_t capacity() const
+		{
+			return this->limit;
+		}
+
+		/**
+		 * The number of entries evicted to make room since the cache_table was created.
+		 */
+		std::size_t evictions() const
+		{
+			return this->evicted;
+		}
+
+		/**
+		 * The stats of the underlying hash_table, see hash_table::stats.
+		 */
+		table_stats stats() const
+		{
+			return this->table.stats();
+		}
+
+		/**
+		 * Call the function on every entry, which does not count as a use.
+		 * @param function called as function(const K & key, const T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function) const
+		{
+			this->table.for_each_active(function);
+		}
+
+	private:
+		/**
+		 * The max load factor of the slots, counting entries and tombstones.
+		 */
+		static constexpr float kMaxLoad = 0.8f;
+
+		table_type table;
+
+		/**
+		 * The most entries held.
+		 */
+		std::size_t limit;
+
+		/**
+		 * The slot the clock hand checks next.
+		 */
+		std::size_t hand{};
+
+		std::size_t evicted{};
+
+		/**
+		 * Insert or replace the entry of the key with a single probe, see insert.
+		 * A new entry may take the cache_table one past its capacity, then another
+		 * entry is evicted right away.
+		 */
+		template <typename V, typename Q>
+		bool insert_entry(V && value, Q && key)
+		{
+			const auto result = this->table.emplace_entry(std::forward<Q>(key), std::forward<V>(value));
+			auto & array = this->table.array;
+			const auto position = static_cast<std::size_t>(result.first - array.slots);
+			if (!result.second)
+			{ // the value was not used to build a new entry, so it is still ours to assign.
+				result.first->element = std::forward<V>(value);
+				array.referenced[position] = 1;
+			}
+			else if (this->table.size() > this->limit)
+			{
+				this->evict(position);
+			} // else, there was room left, do_nothing();
+			return result.second;
+		}
+
+		/**
+		 * Move the clock hand to the first active entry that was not used since the
+		 * hand last passed it, clearing the reference byte of every entry on the
+		 * way, and evict it. Ends within two turns of the hand.
+		 * Only the current array is walked, since a cache_table never enables the
+		 * incremental resize of its hash_table. If it ever did, an evict while every
+		 * entry was still in the old array would loop forever.
+		 * @param keep the slot of the entry just inserted, which is passed over.
+		 */
+		void evict(const std::size_t keep)
+		{
+			auto & array = this->table.array;
+			const auto size = array.size();
+			while (true)
+			{
+				this->hand = table_type::next_active(array, this->hand, size);
+				if (this->hand == size)
+				{
+					this->hand = 0;
+				}
+				else if (this->hand == keep)
+				{ // the new entry is left alone, the cache_table holds at least one other to evict.
+					++this->hand;
+				}
+				else if (array.referenced[this->hand] != 0)
+				{ // a second chance, the entry is only evicted if it is not used before the hand comes back.
+					array.referenced[this->hand] = 0;
+					++this->hand;
+				}
+				else
+				{
+					this->table.erase_entry(array.slots + this->hand);
+					++this->hand;
+					++this->evicted;
+					return;
+				}
+			}
+		}
+	};
+}
+
+#endif
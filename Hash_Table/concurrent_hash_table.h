@@ -0,0 +1,294 @@
+#ifndef CONCURRENT_HASH_TABLE_H_
+#define CONCURRENT_HASH_TABLE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+
+#include "hash_policy.h"
+#include "hash_table.h"
+
+namespace nwacc {
+
+	/**
+	 * A hash_table that can be used from many threads at once. The keys are split
+	 * over a power of two number of shards, each one a hash_table behind its own
+	 * reader-writer lock, so threads working on different shards never wait on
+	 * each other. Lookups only take the lock of their shard for reading.
+	 * No reference into the table is ever handed out, visit() runs a callback on
+	 * the value while the lock is held instead.
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename Policy = power_of_two_policy>
+	class concurrent_hash_table
+	{
+	public:
+		typedef hash_table<T, K, Hash, KeyEqual, Policy> table_type;
+
+		/**
+		 * Create an empty concurrent_hash_table.
+		 * @param shards the number of shards, rounded up to a power of two. Zero picks
+		 * four shards per hardware thread.
+		 * @param size the number of slots to start each shard with.
+		 */
+		explicit concurrent_hash_table(std::size_t shards = 0, const int size = 7,
+			const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual())
+			: hasher(hash)
+		{
+			if (shards == 0)
+			{
+				shards = 4 * std::max(1u, std::thread::hardware_concurrency());
+			} // else, the caller picked the number of shards, do_nothing();
+
+			this->shard_bits = 0;
+			while ((std::size_t{ 1 } << this->shard_bits) < shards)
+			{
+				++this->shard_bits;
+			}
+			this->shard_total = std::size_t{ 1 } << this->shard_bits;
+
+			// every shard builds its hash_table once, at the requested size.
+			auto storage = std::allocator<shard>().allocate(this->shard_total);
+			std::size_t built = 0;
+			try
+			{
+				for (; built < this->shard_total; built++)
+				{
+					::new (static_cast<void *>(storage + built)) shard(size, hash, equal);
+				}
+			}
+			catch (...)
+			{
+				while (built > 0)
+				{
+					storage[--built].~shard();
+				}
+				std::allocator<shard>().deallocate(storage, this->shard_total);
+				throw;
+			}
+			this->shards = std::unique_ptr<shard[], shard_deleter>(storage, shard_deleter{ this->shard_total });
+		}
+
+		concurrent_hash_table(const concurrent_hash_table &) = delete;
+
+		concurrent_hash_table & operator=(const concurrent_hash_table &) = delete;
+
+		/**
+		 * Insert the value under the key. If the key is already in the
+		 * concurrent_hash_table its value is replaced.
+		 * @return true if a new entry was inserted.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			auto & current = this->shard_for(key);
+			std::unique_lock<std::shared_mutex> guard(current.lock);
+			return current.table.insert(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics. If the key is
+		 * already in the concurrent_hash_table its value is replaced.
+		 * @return true if a new entry was inserted.
+		 */
+		bool insert(T && value, K && key)
+		{
+			auto & current = this->shard_for(key);
+			std::unique_lock<std::shared_mutex> guard(current.lock);
+			return current.table.insert(std::move(value), std::move(key));
+		}
+
+		/**
+		 * Build a value from the arguments in the slot of the key, if the key is missing.
+		 * @return true if a new entry was inserted.
+		 */
+		template <typename... Args>
+		bool try_emplace(const K & key, Args &&... args)
+		{
+			auto & current = this->shard_for(key);
+			std::unique_lock<std::shared_mutex> guard(current.lock);
+			return current.table.try_emplace(key, std::forward<Args>(args)...).second;
+		}
+
+		/**
+		 * Determine if the concurrent_hash_table contains an entry with a matching key.
+		 */
+		bool contains(const K & key) const
+		{
+			const auto & current = this->shard_for(key);
+			std::shared_lock<std::shared_mutex> guard(current.lock);
+			return current.table.contains(key);
+		}
+
+		/**
+		 * Removes the entry stored under the key.
+		 * @return true if an entry was removed.
+		 */
+		bool remove(const K & key)
+		{
+			auto & current = this->shard_for(key);
+			std::unique_lock<std::shared_mutex> guard(current.lock);
+			return current.table.remove(key);
+		}
+
+		/**
+		 * Call the function on the value stored under the key, while holding the
+		 * lock of its shard for writing, so the value may be changed.
+		 * The function must not call back into the concurrent_hash_table.
+		 * @param key the key being searched for.
+		 * @param function called as function(T &).
+		 * @return true if the key was found and the function called.
+		 */
+		template <typename Function>
+		bool visit(const K & key, Function && function)
+		{
+			auto & current = this->shard_for(key);
+			std::unique_lock<std::shared_mutex> guard(current.lock);
+			auto found = current.table.find(key);
+			if (found == nullptr)
+			{
+				return false;
+			} // else, the key exists, do_nothing();
+			std::forward<Function>(function)(*found);
+			return true;
+		}
+
+		/**
+		 * Call the function on the value stored under the key, while holding the
+		 * lock of its shard for reading.
+		 * The function must not call back into the concurrent_hash_table.
+		 * @param key the key being searched for.
+		 * @param function called as function(const T &).
+		 * @return true if the key was found and the function called.
+		 */
+		template <typename Function>
+		bool visit(const K & key, Function && function) const
+		{
+			const auto & current = this->shard_for(key);
+			std::shared_lock<std::shared_mutex> guard(current.lock);
+			auto found = current.table.find(key);
+			if (found == nullptr)
+			{
+				return false;
+			} // else, the key exists, do_nothing();
+			std::forward<Function>(function)(*found);
+			return true;
+		}
+
+		/**
+		 * The number of entries. Each shard is counted under its own lock, so the
+		 * total is only exact while no other thread is changing the table.
+		 */
+		std::size_t size() const
+		{
+			std::size_t total = 0;
+			for (std::size_t i = 0; i < this->shard_total; i++)
+			{
+				std::shared_lock<std::shared_mutex> guard(this->shards[i].lock);
+				total += this->shards[i].table.size();
+			}
+			return total;
+		}
+
+		/**
+		 * Remove every entry, one shard at a time.
+		 */
+		void make_empty()
+		{
+			for (std::size_t i = 0; i < this->shard_total; i++)
+			{
+				std::unique_lock<std::shared_mutex> guard(this->shards[i].lock);
+				this->shards[i].table.make_empty();
+			}
+		}
+
+		/**
+		 * The number of shards the keys are split over.
+		 */
+		std::size_t shard_count() const
+		{
+			return this->shard_total;
+		}
+
+	private:
+		/**
+		 * The size of a cache line on the targets we build for.
+		 */
+		enum { kCacheLine = 64 };
+
+		/**
+		 * One shard, aligned to a cache line so the locks of two shards never
+		 * share a line and a writer on one does not slow down readers of the other.
+		 */
+		struct alignas(kCacheLine) shard
+		{
+			shard(const int size, const Hash & hash, const KeyEqual & equal)
+				: table(size, hash, equal)
+			{
+			}
+
+			mutable std::shared_mutex lock;
+			table_type table;
+		};
+
+		/**
+		 * Destroys the shards built in place by the constructor and releases their storage.
+		 */
+		struct shard_deleter
+		{
+			std::size_t count;
+
+			void operator()(shard * shards) const
+			{
+				for (std::size_t i = 0; i < this->count; i++)
+				{
+					shards[i].~shard();
+				}
+				std::allocator<shard>().deallocate(shards, this->count);
+			}
+		};
+
+		/**
+		 * The shards, allocated once and never moved.
+		 */
+		std::unique_ptr<shard[], shard_deleter> shards;
+
+		/**
+		 * The number of shards, a power of two.
+		 */
+		std::size_t shard_total{};
+
+		/**
+		 * The number of hash bits used to pick a shard.
+		 */
+		unsigned shard_bits{};
+
+		/**
+		 * The function object hashing the keys to pick their shard.
+		 */
+		Hash hasher;
+
+		/**
+		 * The shard of the key. It is picked from the high bits of the mixed hash,
+		 * the hash_table of the shard finds the home bucket from the low bits, so
+		 * the keys of one shard still spread over all of its slots.
+		 */
+		shard & shard_for(const K & key) const
+		{
+			if (this->shard_bits == 0)
+			{ // a single shard, and a shift by the whole width of the hash is undefined.
+				return this->shards[0];
+			} // else, the high bits pick the shard, do_nothing();
+			const auto mixed = mix(this->hasher(key));
+			return this->shards[mixed >> (sizeof(std::size_t) * 8 - this->shard_bits)];
+		}
+	};
+}
+
+#endif
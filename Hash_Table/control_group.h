@@ -0,0 +1,220 @@
+#ifndef CONTROL_GROUP_H_
+#define CONTROL_GROUP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(NWACC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NWACC_GROUP_SSE2 1
+#include <emmintrin.h>
+#elif !defined(NWACC_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define NWACC_GROUP_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace nwacc {
+
+	/**
+	 * One byte of metadata kept per slot, separate from the entry storage.
+	 * A full slot holds the low 7 bits of the hash of its key (0 to 127),
+	 * an empty or deleted slot holds one of the negative values below.
+	 */
+	typedef std::int8_t control_byte;
+
+	/**
+	 * The marker values of a control_byte that does not hold an entry.
+	 */
+	enum control_marker : control_byte { kControlEmpty = -128, kControlDeleted = -2 };
+
+	/**
+	 * Count the number of zero bits below the lowest set bit.
+	 * @param bits the bits being searched, must not be zero.
+	 * @return the index of the lowest set bit.
+	 */
+	inline unsigned count_trailing_zeros(const std::uint64_t bits)
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(bits)))
+		{
+			return static_cast<unsigned>(index);
+		} // else, the bit is in the high half, do_nothing();
+		_BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+		return static_cast<unsigned>(index) + 32;
+#else
+		return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+	}
+
+	/**
+	 * The set of slots of a control_group matching a compare, walked from
+	 * the lowest slot up. Each slot owns Shift bits of the mask, so the mask
+	 * can hold 1 bit per slot (SSE2 and portable) or 4 bits per slot (NEON).
+	 */
+	template <unsigned Shift>
+	class bit_mask
+	{
+	public:
+		explicit bit_mask(const std::uint64_t bits) : mask(bits) { }
+
+		/**
+		 * Determine if any slot matched.
+		 */
+		explicit operator bool() const
+		{
+			return this->mask != 0;
+		}
+
+		/**
+		 * The index in the group of the lowest matching slot.
+		 */
+		std::size_t lowest() const
+		{
+			return count_trailing_zeros(this->mask) >> Shift;
+		}
+
+		/**
+		 * Drop the lowest matching slot from the set.
+		 */
+		void next()
+		{
+			this->mask &= this->mask - 1;
+		}
+
+	private:
+		std::uint64_t mask;
+	};
+
+	/**
+	 * A window of 16 control bytes that is compared in one go, with SSE2 or
+	 * NEON when they are available and with a plain loop otherwise.
+	 * Defining NWACC_NO_SIMD forces the plain loop.
+	 */
+	class control_group
+	{
+	public:
+		/**
+		 * The number of slots covered by one group.
+		 */
+		static const std::size_t kWidth = 16;
+
+#if defined(NWACC_GROUP_SSE2)
+		typedef bit_mask<0> mask_type;
+
+		explicit control_group(const control_byte * position)
+			: bytes(_mm_loadu_si128(reinterpret_cast<const __m128i *>(position))) { }
+
+		/**
+		 * The slots whose control byte equals the value.
+		 */
+		mask_type match(const control_byte value) const
+		{
+			return mask_type(static_cast<std::uint32_t>(
+				_mm_movemask_epi8(_mm_cmpeq_epi8(this->bytes, _mm_set1_epi8(value)))));
+		}
+
+		/**
+		 * The slots that are empty or deleted, which are the slots with the sign bit set.
+		 */
+		mask_type match_empty_or_deleted() const
+		{
+			return mask_type(static_cast<std::uint32_t>(_mm_movemask_epi8(this->bytes)));
+		}
+
+	private:
+		__m128i bytes;
+
+#elif defined(NWACC_GROUP_NEON)
+		typedef bit_mask<2> mask_type;
+
+		explicit control_group(const control_byte * position) : bytes(vld1q_s8(position)) { }
+
+		/**
+		 * The slots whose control byte equals the value.
+		 */
+		mask_type match(const control_byte value) const
+		{
+			return to_mask(vceqq_s8(this->bytes, vdupq_n_s8(value)));
+		}
+
+		/**
+		 * The slots that are empty or deleted, which are the slots with the sign bit set.
+		 */
+		mask_type match_empty_or_deleted() const
+		{
+			return to_mask(vcltq_s8(this->bytes, vdupq_n_s8(0)));
+		}
+
+	private:
+		int8x16_t bytes;
+
+		/**
+		 * Narrow a per byte compare result to 4 bits per slot, keeping one bit of each nibble.
+		 */
+		static mask_type to_mask(const uint8x16_t compare)
+		{
+			const auto narrowed = vshrn_n_u16(vreinterpretq_u16_u8(compare), 4);
+			return mask_type(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL);
+		}
+
+#else
+		typedef bit_mask<0> mask_type;
+
+		explicit control_group(const control_byte * position)
+		{
+			for (std::size_t i = 0; i < kWidth; i++)
+			{
+				this->bytes[i] = position[i];
+			}
+		}
+
+		/**
+		 * The slots whose control byte equals the value.
+		 */
+		mask_type match(const control_byte value) const
+		{
+			std::uint64_t bits = 0;
+			for (std::size_t i = 0; i < kWidth; i++)
+			{
+				if (this->bytes[i] == value) bits |= std::uint64_t{ 1 } << i;
+			}
+			return mask_type(bits);
+		}
+
+		/**
+		 * The slots that are empty or deleted, which are the slots with the sign bit set.
+		 */
+		mask_type match_empty_or_deleted() const
+		{
+			std::uint64_t bits = 0;
+			for (std::size_t i = 0; i < kWidth; i++)
+			{
+				if (this->bytes[i] < 0) bits |= std::uint64_t{ 1 } << i;
+			}
+			return mask_type(bits);
+		}
+
+	private:
+		control_byte bytes[kWidth];
+#endif
+
+	public:
+		/**
+		 * The slots that are empty.
+		 */
+		mask_type match_empty() const
+		{
+			return this->match(kControlEmpty);
+		}
+	};
+}
+
+#endif
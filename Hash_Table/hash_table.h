@@ -2,39 +2,249 @@
 #define HASH_TABLE_H_
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "control_group.h"
+#include "hash_policy.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "table_stats.h"
+
 namespace nwacc {
 
-	template <typename T, typename K>
+	template <typename T, typename K, typename Hash, typename KeyEqual, typename Allocator>
+	class cache_table;
+
+	/**
+	 * Open addressing hash_table of values T stored under keys K.
+	 * Entries are placed and found by hashing the key, the same way std::unordered_map does.
+	 * @tparam Hash the function object hashing a key.
+	 * @tparam KeyEqual the function object comparing two keys for equality.
+	 * @tparam Policy the capacity policy deciding the table size, the home bucket
+	 * of a hash code, and the probe sequence. See hash_policy.h.
+	 * @tparam Allocator the allocator of the slot storage, rebound to the internal
+	 * slot types. A stateful allocator, such as a std::pmr::polymorphic_allocator,
+	 * is also handed to every T and K constructed with an allocator.
+	 * Whether the hash code of every entry is kept next to it is decided by
+	 * cache_hash_code<K>, see hash_policy.h.
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>,
+		typename Policy = power_of_two_policy,
+		typename Allocator = std::allocator<T>>
 	class hash_table
 	{
 	public:
+		typedef Allocator allocator_type;
+
 	    /**
-		 * note made this seven so we could see this work when printing. 
+		 * note made this seven so we could see this work when printing.
 		 */
-		explicit hash_table(int size = 7) : array(next_prime(size))
+		explicit hash_table(int size = 7, const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual(),
+			const Allocator & allocator = Allocator())
+			: array(Policy::next_size(size), allocator), old_array(allocator), hasher(hash), key_equal(equal)
 		{
+			this->grow_threshold = this->threshold_for(this->array.size());
 			this->make_empty();
 		}
 
 		/**
-		 * Determine if the current position in the hash_table contains a matching key.
+		 * Build a hash_table from a range of key and value pairs in one go, see insert_range.
+		 * @param first the first pair, with the key in first and the value in second.
+		 * @param last one past the last pair.
+		 */
+		template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+		hash_table(It first, It last, const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual(),
+			const Allocator & allocator = Allocator())
+			: hash_table(7, hash, equal, allocator)
+		{
+			this->insert_range(first, last);
+		}
+
+		hash_table(const hash_table & rhs) = default;
+
+		/**
+		 * Move the entries of another hash_table, which is left empty with no
+		 * slots and allocates again on its next insert.
+		 */
+		hash_table(hash_table && rhs) noexcept(std::is_nothrow_move_constructible<Hash>::value &&
+			std::is_nothrow_move_constructible<KeyEqual>::value)
+			: array(std::move(rhs.array)), old_array(std::move(rhs.old_array)),
+			migrate_position(rhs.migrate_position), step_budget(rhs.step_budget), rehash_threads(rhs.rehash_threads),
+			load_limit(rhs.load_limit), grow_threshold(rhs.grow_threshold), current_size(rhs.current_size),
+			deleted_size(rhs.deleted_size), hasher(std::move(rhs.hasher)), key_equal(std::move(rhs.key_equal)),
+			recorder(rhs.recorder)
+		{
+			rhs.forget_entries();
+		}
+
+		hash_table & operator=(const hash_table & rhs) = default;
+
+		/**
+		 * Move the entries of another hash_table, see the move constructor.
+		 */
+		hash_table & operator=(hash_table && rhs) noexcept(std::is_nothrow_move_assignable<Hash>::value &&
+			std::is_nothrow_move_assignable<KeyEqual>::value)
+		{
+			if (this != &rhs)
+			{
+				this->array = std::move(rhs.array);
+				this->old_array = std::move(rhs.old_array);
+				this->migrate_position = rhs.migrate_position;
+				this->step_budget = rhs.step_budget;
+				this->rehash_threads = rhs.rehash_threads;
+				this->load_limit = rhs.load_limit;
+				this->grow_threshold = rhs.grow_threshold;
+				this->current_size = rhs.current_size;
+				this->deleted_size = rhs.deleted_size;
+				this->hasher = std::move(rhs.hasher);
+				this->key_equal = std::move(rhs.key_equal);
+				this->recorder = rhs.recorder;
+				rhs.forget_entries();
+			} // else, it is the same table, do_nothing();
+			return *this;
+		}
+
+		/**
+		 * The allocator of the slot storage.
+		 */
+		allocator_type get_allocator() const
+		{
+			return allocator_type(this->array.allocator);
+		}
+
+		/**
+		 * Determine if the hash_table contains an entry with a matching key.
 		 */
 		bool contains(const K & key) const
 		{
-			return this->is_active(this->find_position(key));
+			return this->find_entry(key) != nullptr;
+		}
+
+		/**
+		 * Determine if the hash_table contains an entry with a key equal to a value
+		 * of another type, such as a std::string_view for std::string keys, without
+		 * building a temporary key. Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		bool contains(const Q & key) const
+		{
+			return this->find_entry(key) != nullptr;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const K & key)
+		{
+			this->migrate_step();
+			auto found = this->find_entry(key);
+			return found == nullptr ? nullptr : &found->element;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const K & key) const
+		{
+			auto found = this->find_entry(key);
+			return found == nullptr ? nullptr : &found->element;
+		}
+
+		/**
+		 * Find the value stored under a key equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 * @param key the value compared against the keys.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		T * find(const Q & key)
+		{
+			this->migrate_step();
+			auto found = this->find_entry(key);
+			return found == nullptr ? nullptr : &found->element;
+		}
+
+		/**
+		 * Find the value stored under a key equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 * @param key the value compared against the keys.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		const T * find(const Q & key) const
+		{
+			auto found = this->find_entry(key);
+			return found == nullptr ? nullptr : &found->element;
+		}
+
+		/**
+		 * Look up a batch of keys at once. Every key of a chunk is hashed and its
+		 * home slot prefetched before any probe starts, so the cache misses of the
+		 * chunk overlap instead of being paid one after the other.
+		 * @param keys the keys being searched for.
+		 * @param count the number of keys.
+		 * @param found set for each key to true if it is in the hash_table.
+		 * @return the number of keys found.
+		 */
+		std::size_t contains_batch(const K * keys, const std::size_t count, bool * found) const
+		{
+			std::size_t hits = 0;
+			this->lookup_batch(keys, count, [&](const std::size_t i, const entry * match)
+			{
+				found[i] = match != nullptr;
+				hits += found[i];
+			});
+			return hits;
+		}
+
+		/**
+		 * Find the values of a batch of keys at once, prefetching like contains_batch.
+		 * @param keys the keys being searched for.
+		 * @param count the number of keys.
+		 * @param values set for each key to its value, or to nullptr when it is missing.
+		 * @return the number of keys found.
+		 */
+		std::size_t find_batch(const K * keys, const std::size_t count, const T ** values) const
+		{
+			std::size_t hits = 0;
+			this->lookup_batch(keys, count, [&](const std::size_t i, const entry * match)
+			{
+				values[i] = match == nullptr ? nullptr : &match->element;
+				hits += match != nullptr;
+			});
+			return hits;
 		}
 
 		/**
-		 * Determine if the current position in the hash_table contains a matching value.
+		 * Determine if the hash_table contains an entry with a matching value.
+		 * Entries are not indexed by value, so this walks every slot of the hash_table,
+		 * a bimap_table indexes a one to one map both ways.
 		 */
-		bool contains(const T & value) const
+		bool contains_value(const T & value) const
 		{
-			return this->is_active(this->find_position(value));
+			return this->find_value_entry(value) != nullptr;
 		}
 
 		/**
@@ -43,354 +253,2443 @@ namespace nwacc {
 		void make_empty()
 		{
 			this->current_size = 0;
-			for (auto & entry : this->array)
-			{
-				entry.type = kEmpty;
-			}
+			this->deleted_size = 0;
+			this->array.clear();
+			this->old_array.release();
+			this->migrate_position = 0;
 		}
 
 		/**
 		* Insert the value, key, and set the is_active state of the current item in the hash_table.
+		* If the key is already in the hash_table its value is replaced.
 		* @param value the data to be inserted.
 		* @param key the key to be inserted.
 		* @return true if the current position in the hash_table has a value, key, and state inserted.
-		* @return false if the current position in the hash_table has not had a value, key, and state inserted.
+		* @return false if the key was already in the hash_table.
 		*/
 		bool insert(const T & value, const K & key)
 		{
-			auto current_position = this->find_position(key);
-			if (this->is_active(current_position))
-			{
-				if (this->array[current_position].key == key)
-				{
-					this->array[current_position].element = value;
-				} // else, current key is not already on the hash_table, do_nothing();
-				return false;
-			}
-			else
-			{
-				this->array[current_position].element = value;
-				this->array[current_position].key = key;
-				this->array[current_position].type = kActive;
-			}
-
-			if (++this->current_size > this->array.size() / 2)
-			{ // this has a load factor of 50%
-				this->rehash();
-			} // else we are within the load factor do_nothing();
-
-			return true;
+			return this->insert_entry(value, key);
 		}
 
 		/**
 		 * Insert the value, key, and set the is_active state of the current item in the hash_table with move semantics.
+		 * If the key is already in the hash_table its value is replaced.
 		 * @param value the data to be inserted.
 		 * @param key the key to be inserted.
 		 * @return true if the current position in the hash_table has a value, key, and state inserted.
-		 * @return false if the current position in the hash_table has not had a value, key, and state inserted.
+		 * @return false if the key was already in the hash_table.
 		 */
 		bool insert(T && value, K && key)
 		{
-		 	auto current_position = this->find_position(key);
-		 	if (this->is_active(current_position))
-		 	{
-				if (this->array[current_position].key == key)
-				{
-					this->array[current_position].element = std::move(value);
-				} // else, current key is not already on the hash_table, do_nothing();
-		 		return false;
-		 	}
-		 	else
-		 	{
-		 		this->array[current_position] = std::move(value);
-				this->array[current_position] = std::move(key);
-		 		this->array[current_position].type = kActive;
-		 	}
-		
-		 	if (++this->current_size > this->array.size() / 2)
-		 	{
-		 		this->rehash();
-		 	} // else, still within the load factor, do_nothing();
-		
-		 	return true;
+			return this->insert_entry(std::move(value), std::move(key));
 		}
 
 		/**
-		 * Removes the key at the current position in the hash_table.
-		 * @param key the key to remove.
-		 * @return true if the key has been set to value kDeleted.
-		 * @return false if the key is not active.
+		 * Insert the value under the key, or assign it to the value already stored under the key.
+		 * @param key the key to be inserted.
+		 * @param value the data to be inserted or assigned.
+		 * @return the stored value, and true if a new entry was inserted.
 		 */
-		bool remove(const K & key)
+		template <typename V>
+		std::pair<T *, bool> insert_or_assign(const K & key, V && value)
+		{
+			return this->assign_entry(key, std::forward<V>(value));
+		}
+
+		/**
+		 * Insert the value under the key, or assign it to the value already stored
+		 * under the key, moving the key into the hash_table.
+		 * @param key the key to be inserted.
+		 * @param value the data to be inserted or assigned.
+		 * @return the stored value, and true if a new entry was inserted.
+		 */
+		template <typename V>
+		std::pair<T *, bool> insert_or_assign(K && key, V && value)
+		{
+			return this->assign_entry(std::move(key), std::forward<V>(value));
+		}
+
+		/**
+		 * Build a value from the arguments straight in the slot of the key, if the
+		 * key is missing. Nothing is built or moved from when the key is already
+		 * in the hash_table.
+		 * @param key the key to be inserted.
+		 * @param args the arguments for the constructor of the value.
+		 * @return the stored value, and true if a new entry was inserted.
+		 */
+		template <typename... Args>
+		std::pair<T *, bool> try_emplace(const K & key, Args &&... args)
+		{
+			const auto result = this->emplace_entry(key, std::forward<Args>(args)...);
+			return { &result.first->element, result.second };
+		}
+
+		/**
+		 * Build a value from the arguments straight in the slot of the key, if the
+		 * key is missing, moving the key into the hash_table.
+		 * @param key the key to be inserted.
+		 * @param args the arguments for the constructor of the value.
+		 * @return the stored value, and true if a new entry was inserted.
+		 */
+		template <typename... Args>
+		std::pair<T *, bool> try_emplace(K && key, Args &&... args)
+		{
+			const auto result = this->emplace_entry(std::move(key), std::forward<Args>(args)...);
+			return { &result.first->element, result.second };
+		}
+
+		/**
+		 * Build the key and the value straight in their slot, if the key is missing.
+		 * The key is built from anything K can be built from, such as a const char *
+		 * for std::string keys. A key of another type is built up front unless the
+		 * Hash and KeyEqual are transparent and can look it up as it is.
+		 * @param key the argument for the constructor of the key.
+		 * @param args the arguments for the constructor of the value.
+		 * @return the stored value, and true if a new entry was inserted.
+		 */
+		template <typename Q, typename... Args>
+		std::pair<T *, bool> emplace(Q && key, Args &&... args)
 		{
-			auto current_position = this->find_position(key);
-			if (!this->is_active(current_position))
+			if constexpr (std::is_same<typename std::decay<Q>::type, K>::value ||
+				(is_transparent<Hash>::value && is_transparent<KeyEqual>::value))
 			{
-				return false;
+				const auto result = this->emplace_entry(std::forward<Q>(key), std::forward<Args>(args)...);
+				return { &result.first->element, result.second };
 			}
 			else
 			{
-				this->array[current_position].type = kDeleted;
-				return true;
+				return this->try_emplace(K(std::forward<Q>(key)), std::forward<Args>(args)...);
+			}
+		}
+
+		/**
+		 * Insert a range of key and value pairs, such as the elements of a std::map
+		 * or a std::vector of std::pair. The hash_table is sized once for the whole
+		 * range, every key is hashed in parallel, and the entries are sorted by home
+		 * bucket with a radix partition and placed in slot order, with no load
+		 * checks and no rehash along the way. Like insert, a key already in the
+		 * hash_table, or repeated in the range, ends up with the last value given.
+		 * Use std::make_move_iterator to move the keys and values in.
+		 * @param first the first pair, with the key in first and the value in second.
+		 * @param last one past the last pair.
+		 * @return the number of new entries.
+		 */
+		template <typename It>
+		std::size_t insert_range(It first, It last)
+		{
+			static_assert(std::is_base_of<std::random_access_iterator_tag,
+				typename std::iterator_traits<It>::iterator_category>::value,
+				"insert_range needs random access iterators");
+
+			const auto count = static_cast<std::size_t>(last - first);
+			if (count == 0)
+			{
+				return 0;
+			} // else, there is something to insert, do_nothing();
+			this->reserve(this->current_size + count);
+
+			std::vector<std::size_t> codes(count);
+			parallel_for(count, [&](const std::size_t begin, const std::size_t end)
+			{
+				for (auto i = begin; i < end; i++)
+				{
+					codes[i] = this->hasher(first[i].first);
+				}
+			});
+
+			const auto order = this->partition_by_home(codes);
+			const auto before = this->current_size;
+			for (const auto i : order)
+			{
+				auto && item = first[i];
+				probe_counter probes;
+				const auto current_position = this->find_insert_position(codes[i], item.first, probes);
+				if (this->is_active(current_position))
+				{
+					this->array.slots[current_position].element = std::forward<decltype(item)>(item).second;
+					this->array.touch(current_position);
+				}
+				else
+				{
+					this->recorder.record_insert(probes);
+					const auto reused = this->array.types[current_position] == kDeleted;
+					this->array.construct(current_position, codes[i], std::forward<decltype(item)>(item).first,
+						std::forward<decltype(item)>(item).second);
+					if (reused)
+					{
+						--this->deleted_size;
+					} // else, an empty slot is used, do_nothing();
+					++this->current_size;
+				}
 			}
+			return this->current_size - before;
+		}
+
+		/**
+		 * Removes the key at the current position in the hash_table.
+		 * @param key the key to remove.
+		 * @return true if the key has been set to value kDeleted.
+		 * @return false if the key is not active.
+		 */
+		bool remove(const K & key)
+		{
+			return this->remove_key(key);
+		}
+
+		/**
+		 * Removes the entry whose key is equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 * @param key the value compared against the keys.
+		 * @return true if the key has been set to value kDeleted.
+		 * @return false if the key is not active.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		bool remove(const Q & key)
+		{
+			return this->remove_key(key);
 		}
 
 		/**
-		 * Removes the value at the current position in the hash_table.
+		 * Removes the first entry holding the value.
+		 * Entries are not indexed by value, so this walks every slot of the hash_table.
 		 * @param value the data to remove.
 		 * @return true if the data has been set to value kDeleted.
 		 * @return false if the value is not active.
 		 */
-		bool remove(const T & value)
+		bool remove_value(const T & value)
 		{
-			auto current_position = this->find_position(value);
-			if (!this->is_active(current_position))
+			this->migrate_step();
+			auto found = const_cast<entry *>(this->find_value_entry(value));
+			if (found == nullptr)
 			{
 				return false;
 			}
 			else
 			{
-				this->array[current_position].type = kDeleted;
+				this->erase_entry(found);
 				return true;
 			}
 		}
 
 		/**
-		 * enum data structure containing the three types.
+		 * The number of entries in the hash_table.
 		 */
-		enum entry_type { kActive, kEmpty, kDeleted };
+		std::size_t size() const
+		{
+			return this->current_size;
+		}
 
 		/**
-		 * Print all of the values in the hash_table to the console window.
-		 * @param out the overload of the cout operator.
+		 * The number of deleted slots of the array still waiting to be reclaimed.
+		 * Deleted slots are reused by inserts and dropped when the hash_table is rehashed.
 		 */
-		void print(std::ostream & out = std::cout)
+		std::size_t tombstone_count() const
 		{
-			for (auto entry : this->array)
-			{
-				out << entry.element << " {" << this->get_type(entry) << "} | ";
-			}
-			out << std::endl;
+			return this->deleted_size;
 		}
 
 		/**
-		 * Returns the value of the key in the current position in the hash_table.
-		 * If the key does not exist in the hash_table throw a length error.
+		 * The fraction of slots, entries and tombstones together, that may be in
+		 * use before the hash_table grows. Defaults to 0.5.
 		 */
-		void get_key(const K & key)
+		float max_load_factor() const
 		{
-			auto current_position = this->find_position(key);
-			if (array[current_position].type == !kActive)
-			{
-				throw std::length_error("Key not found....");
-			} // else, key exists in the table do_nothing();
-			return this->array[current_position].element;
+			return this->load_limit;
 		}
 
 		/**
-		* Returns the value of the element in the current position in the hash_table.
-		* If the element does not exist in the hash_table throw a length error.
-		*/
-		void get_value(const T & value)
+		 * The number of entries per slot of the current array, tombstones not counted.
+		 */
+		float load_factor() const
 		{
-			auto current_position = this->find_position(value);
-			if(array[current_position].type == !kActive)
-			{
-				throw std::length_error("Value not found....");
-			} // else, value exists in the table do_nothing();
-			return this->array[current_position].key;
+			return this->array.empty() ? 0.0f :
+				static_cast<float>(this->current_size) / static_cast<float>(this->array.size());
 		}
 
 		/**
-		 * Print the hash_table forwards and backwards.
+		 * How the hash_table is doing, see table_stats. The probe histograms and
+		 * rehash counters are only recorded when NWACC_HASH_TABLE_STATS is defined.
 		 */
-		void print()
+		table_stats stats() const
 		{
-			// Forwards
-			for (auto i = 0; i <= array->size; i++)
+			table_stats result;
+			result.size = this->current_size;
+			result.capacity = this->array.size();
+			result.tombstones = this->deleted_size;
+			result.load_factor = this->load_factor();
+			this->recorder.fill(result);
+			return result;
+		}
+
+		/**
+		 * Set the fraction of slots that may be in use before the hash_table grows,
+		 * growing right away if the hash_table is already past it. The value is
+		 * capped at the highest load factor the probe sequence of the capacity
+		 * policy supports, 0.5 for prime sizes and 0.95 for powers of two.
+		 * @param load the new max load factor, greater than zero.
+		 */
+		void max_load_factor(const float load)
+		{
+			if (!(load > 0.0f))
 			{
-				std::cout << get_key(array[i]) << " | " << get_value(array[i]) << std::endl;
-			}
+				throw std::invalid_argument("Max load factor must be greater than zero....");
+			} // else, the load factor is valid, do_nothing();
+			this->load_limit = std::min(load, Policy::max_load_factor());
+			this->grow_threshold = this->threshold_for(this->array.size());
+			if (this->current_size + this->deleted_size > this->grow_threshold)
+			{
+				this->rehash(0);
+			} // else we are within the load factor do_nothing();
+		}
 
-			// Backwards
-			for (auto i = array->size; i >= 0; i--)
+		/**
+		 * Make room for the given number of entries, so inserting that many
+		 * entries never rehashes. Never shrinks the hash_table.
+		 * @param count the number of entries to make room for.
+		 */
+		void reserve(const std::size_t count)
+		{
+			if (count + this->deleted_size > this->grow_threshold || this->is_resizing())
 			{
-				std::cout << get_key(array[i]) << " | " << get_value(array[i]) << std::endl;
-			}
+				this->rehash(this->slots_for(count));
+			} // else, there is already room, do_nothing();
 		}
 
 		/**
-		 * Overload the insertion operator for printing of the hash_table.
-		 * @return the hash_table to the command line.
+		 * Rebuild the hash_table with at least the given number of slots, and never
+		 * fewer than needed to hold the current entries under the max load factor.
+		 * Tombstones are dropped and any running incremental resize is finished.
+		 * @param count the minimum number of slots.
 		 */
-	    friend std::ostream operator<<(std::ostream & out, const hash_table & rhs)
-	    {
-			return out << rhs.print() << std::endl;
+		void rehash(const std::size_t count)
+		{
+			this->rehash_to(std::max(Policy::next_size(count), this->slots_for(this->current_size)), false);
 		}
 
 		/**
-		 * Overload the subscript operator to allow the return of the data in the current
-		 * position in the hash_table. Or to allow us to change the data in the current
-		 * position of the hash_table.
-		 * @param key the current key at the current position in the hash_table.
-		 * @return the current key.
+		 * Rebuild the hash_table at the smallest size that holds the current entries.
 		 */
-		T &operator[](const K & key)
+		void shrink_to_fit()
 		{
-			auto current_position = this->find_position(key);
-			// TODO: Create way to change data in the current_position.
-			if (this->array[current_position].element != this->array[current_position].key) // TODO: Fix If Statement
-			{
-				return this->insert[current_position];
-			}
-			return this->array[current_position].element;
+			this->rehash(0);
 		}
 
-	private:
 		/**
-		 * Determine if the current value is a prime number or not.
-		 * @param number the value being checked for primeness.
-		 * @return true if the current number is prime.
-		 * @return false if the current number is not prime.
+		 * Rebuild the hash_table as rehash does, moving the entries on many threads.
+		 * The old slots are split into chunks, and the entries of every chunk are
+		 * first sorted by the region of the new array holding their home slot.
+		 * Then one task per region moves its entries, and only that task touches
+		 * the slots of the region, so no locks or atomics are needed. The few
+		 * entries whose probe sequence leaves their region are moved afterwards
+		 * on the calling thread. The Hash must be safe to call from many threads.
+		 * @param count the minimum number of slots, zero to only drop the tombstones.
+		 * @param executor runs the tasks, see thread_executor.
 		 */
-		static bool is_prime(const int number)
+		template <typename Executor = thread_executor>
+		void parallel_rehash(const std::size_t count, Executor && executor = Executor())
 		{
-			if (number == 2 || number == 3) return true;
-			if (number == 1 || number % 2 == 0) return false;
-			for (auto counter = 3; counter * counter <= number; counter += 2)
-				if (number % counter == 0) return false;
+			this->parallel_rehash_to(std::max(Policy::next_size(count), this->slots_for(this->current_size)), executor);
+		}
 
-			return true;
+		/**
+		 * Set how many threads move the entries when the hash_table grows or drops
+		 * its tombstones, see parallel_rehash. Only an array of at least
+		 * kParallelRehashSlots slots is moved in parallel, and an incremental
+		 * resize always moves its entries on the calling thread.
+		 * @param threads 1, the default, to move on the calling thread, 0 for one per hardware thread.
+		 */
+		void parallel_rehash_threads(const unsigned threads)
+		{
+			this->rehash_threads = threads;
 		}
 
 		/**
-		 * Determine if the next value is a prime number or not.
-		 * @param number the value being checked for primeness.
-		 * @return true if the current number is prime.
-		 * @return false if the current number is not prime.
+		 * The number of threads moving the entries when the hash_table grows, see parallel_rehash_threads.
 		 */
-		static int next_prime(int number)
+		unsigned parallel_rehash_threads() const
 		{
-			if (number % 2 == 0) ++number;
-			while (!is_prime(number)) number += 2;
-			return number;
+			return this->rehash_threads;
 		}
 
 		/**
-		 * Create a new struct of type entry for the hash_table, this entry
-		 * will contain an element, key, and data type(active or inactive).
-		 * @return a new entry.
+		 * Set how many slots of the old array are moved into the new one by each
+		 * insert, remove, and non-const lookup while the hash_table is growing.
+		 * With a budget of zero, the default, the whole hash_table is rehashed inside
+		 * the insert that crosses the load factor. Otherwise growth is spread over
+		 * the following operations and lookups check both arrays until it is done.
+		 * At the default load factor a budget of 2 or more always finishes before
+		 * the next growth is due, a lower max load factor needs a larger budget.
+		 * @param budget the number of old slots moved per operation.
 		 */
-		struct entry
+		void resize_step_budget(const std::size_t budget)
 		{
-			T element;
-			K key;
-			entry_type type;
+			this->step_budget = budget;
+		}
+
+		/**
+		 * The number of old slots moved per operation while growing, zero when growth is done at once.
+		 */
+		std::size_t resize_step_budget() const
+		{
+			return this->step_budget;
+		}
+
+		/**
+		 * Determine if entries are still being moved out of the old array.
+		 */
+		bool is_resizing() const
+		{
+			return !this->old_array.empty();
+		}
 
-			entry(const T & e = T{}, const K & k = K{}, entry_type t = kEmpty)
-				: element{ e }, key{ k }, type{ t } { }
+		/**
+		 * Move every entry left in the old array, ending an incremental resize.
+		 */
+		void finish_resize()
+		{
+			if (this->is_resizing())
+			{
+				this->migrate(this->old_array.size());
+			} // else, no resize is running, do_nothing();
+		}
 
-			entry(T && e, K && k, entry_type t = kEmpty)
-				: element{ std::move(e) }, key{ std::move(k) }, type{ t } { }
-		};
+		class mapped_table;
 
 		/**
-		 * Gets the 'status' of the current value in the hash_table.
-		 * The acceptable types are kEmpty, kActive, and kDeleted.
-		 * @param place the data being checked.
-		 * @return the 'status' of the current value in the hash_table.
+		 * Write the hash_table to a flat image that open_mapped maps straight back
+		 * in: a header, the type byte of every slot, then the slots themselves, laid
+		 * out the same way as in memory. The image can only be read by a build with
+		 * the same T, K, Hash, Policy, and byte order.
+		 * Needs a trivially copyable T and K, and no incremental resize running.
+		 * @param path the file to write, replaced when it exists.
+		 * @throws std::logic_error while a resize is running, see finish_resize.
+		 * @throws std::runtime_error if the file can not be written.
 		 */
-		std::string get_type(const entry & place) const
+		void save(const std::string & path) const
 		{
-			if (place.type == kEmpty)
+			static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<K>::value,
+				"save needs a trivially copyable T and K");
+			if (this->is_resizing())
 			{
-				return "E";
-			}
-			
-			if (place.type == kActive)
+				throw std::logic_error("Can not save while resizing....");
+			} // else, every entry is in the array, do_nothing();
+
+			snapshot_header header{};
+			header.magic = kSnapshotMagic;
+			header.version = kSnapshotVersion;
+			header.entry_size = sizeof(entry);
+			header.entry_align = alignof(entry);
+			header.key_size = sizeof(K);
+			header.value_size = sizeof(T);
+			header.slot_count = this->array.size();
+			header.entry_count = this->current_size;
+			header.slots_offset = snapshot_slots_offset(this->array.size());
+
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char *>(this->array.types.data()), this->array.size());
+			const std::vector<char> padding(header.slots_offset - sizeof(header) - this->array.size());
+			out.write(padding.data(), padding.size());
+
+			// only active slots are copied, the storage of the others is never written.
+			const std::size_t chunk_slots = 1024;
+			std::vector<char> chunk(chunk_slots * sizeof(entry));
+			for (std::size_t begin = 0; begin < this->array.size() && out; begin += chunk_slots)
 			{
-				return "A";
+				const auto end = std::min(begin + chunk_slots, this->array.size());
+				for (auto i = begin; i < end; i++)
+				{
+					auto target = chunk.data() + (i - begin) * sizeof(entry);
+					if (this->array.types[i] == kActive)
+					{
+						std::memcpy(target, this->array.slots + i, sizeof(entry));
+					}
+					else
+					{
+						std::memset(target, 0, sizeof(entry));
+					}
+				}
+				out.write(chunk.data(), (end - begin) * sizeof(entry));
 			}
 
-			return "D";
+			out.flush();
+			if (!out)
+			{
+				throw std::runtime_error("Could not write " + path);
+			} // else, the image is complete, do_nothing();
 		}
 
-	    /**
-		 * Instantiate vector of entry type to hold is_active values.
-		 */
-		std::vector<entry> array;
-
 		/**
-		 * Overload the size_t operator to be the current size of the hash_table.
+		 * Map an image written by save, see mapped_table. Nothing is copied or
+		 * rebuilt, lookups probe the mapped slots directly.
+		 * @param path the file written by save.
+		 * @param hash the hash function, it must hash keys the same as the one used to save.
+		 * @param equal the key equality function.
+		 * @return the read only table over the mapping.
+		 * @throws std::runtime_error if the file can not be mapped or is not an image of this hash_table type.
 		 */
-		std::size_t current_size;
+		static mapped_table open_mapped(const std::string & path, const Hash & hash = Hash(),
+			const KeyEqual & equal = KeyEqual())
+		{
+			return mapped_table(mapped_file(path), hash, equal);
+		}
 
 		/**
-		 * Checks the active state of the current item in the hash_table.
-		 * @param current_position the value being checked.
-		 * @return true if the current value is active.
-		 * @return false if the current value is inactive.
+		 * Write every entry to the stream as raw key and value bytes, a chunk of
+		 * entries at a time, so no copy of the hash_table is built. Unlike save the
+		 * slots are not kept, so the stream can be read back by deserialize under
+		 * any Hash or Policy, by a build with the same T, K, and byte order.
+		 * Needs a trivially copyable T and K.
+		 * @param out the binary stream to write to.
+		 * @throws std::runtime_error if the stream fails.
 		 */
-		bool is_active(int current_position) const
+		void serialize(std::ostream & out) const
 		{
-			return this->array[current_position].type == kActive;
+			static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<K>::value,
+				"serialize needs a trivially copyable T and K");
+			stream_header header{};
+			header.magic = kStreamMagic;
+			header.version = kSnapshotVersion;
+			header.key_size = sizeof(K);
+			header.value_size = sizeof(T);
+			header.entry_count = this->current_size;
+			out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+			const std::size_t record_size = sizeof(K) + sizeof(T);
+			const std::size_t chunk_records = 1024;
+			std::vector<char> chunk(chunk_records * record_size);
+			std::size_t used = 0;
+			for (const auto * table : { &this->array, &this->old_array })
+			{
+				for (std::size_t i = 0; i < table->size() && out; i++)
+				{
+					if (table->types[i] == kActive)
+					{
+						std::memcpy(chunk.data() + used, &table->slots[i].key, sizeof(K));
+						std::memcpy(chunk.data() + used + sizeof(K), &table->slots[i].element, sizeof(T));
+						used += record_size;
+						if (used == chunk.size())
+						{
+							out.write(chunk.data(), used);
+							used = 0;
+						} // else, the chunk has room left, do_nothing();
+					} // else, the slot holds no entry, do_nothing();
+				}
+			}
+			out.write(chunk.data(), used);
+
+			if (!out)
+			{
+				throw std::runtime_error("Could not serialize the hash_table....");
+			} // else, every entry was written, do_nothing();
 		}
 
 		/**
-		 * Find the current position in the hash_table.
-		 * @param value the value whose position is being checked.
-		 * @return the position of the value in the hash_table.
+		 * Replace the contents of the hash_table with the entries written by serialize,
+		 * read a chunk at a time. The slots are reserved once from the entry count
+		 * of the stream, so reading never grows the hash_table.
+		 * If the stream fails part way the entries read so far are kept.
+		 * @param in the binary stream to read from.
+		 * @throws std::runtime_error if the stream fails or was not written by serialize for this T and K.
 		 */
-		int find_position(const T & value) const
+		void deserialize(std::istream & in)
 		{
-			auto off_set = 1;
-			auto current_position = this->hash(value);
+			static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<K>::value,
+				"deserialize needs a trivially copyable T and K");
+			stream_header header{};
+			in.read(reinterpret_cast<char *>(&header), sizeof(header));
+			if (!in || header.magic != kStreamMagic || header.version != kSnapshotVersion ||
+				header.key_size != sizeof(K) || header.value_size != sizeof(T))
+			{
+				throw std::runtime_error("Not a serialized hash_table of this key and value type....");
+			} // else, the records are ours, do_nothing();
 
-			while (this->array[current_position].type != kEmpty &&
-				this->array[current_position].element != value)
+			this->make_empty();
+			this->reserve(static_cast<std::size_t>(header.entry_count));
+
+			const std::size_t record_size = sizeof(K) + sizeof(T);
+			const std::size_t chunk_records = 1024;
+			std::vector<char> chunk(chunk_records * record_size);
+			for (auto left = static_cast<std::size_t>(header.entry_count); left > 0;)
 			{
-				current_position += off_set;
-				off_set += 2;
-				if (current_position >= this->array.size())
+				const auto records = std::min(left, chunk_records);
+				in.read(chunk.data(), records * record_size);
+				if (!in)
+				{
+					throw std::runtime_error("The serialized hash_table is truncated....");
+				} // else, the whole chunk was read, do_nothing();
+
+				for (std::size_t i = 0; i < records; i++)
 				{
-					current_position -= this->array.size();
-				} // else, we have not ran outside the size, do_nothing();
+					const auto record = chunk.data() + i * record_size;
+					this->assign_entry(load_bytes<K>(record), load_bytes<T>(record + sizeof(K)));
+				}
+				left -= records;
 			}
-			return current_position;
 		}
 
 		/**
-		 * Resize the hash_table to be a more appropriate size for the data being inserted.
+		 * Write the slots changed since the last checkpoint to the stream. Every
+		 * block of kDirtyBlock slots has a dirty bit, set by each insert, assign,
+		 * remove, and non-const lookup touching it, so a checkpoint costs the
+		 * blocks written to rather than the whole hash_table. The first checkpoint,
+		 * and the first after the hash_table grows or is emptied, holds every block.
+		 * A running incremental resize is finished first.
+		 * Needs a trivially copyable T and K.
+		 * @param out the binary stream to write to.
+		 * @return the number of blocks written.
+		 * @throws std::runtime_error if the stream fails, the dirty bits are then kept.
 		 */
-		void rehash()
+		std::size_t checkpoint(std::ostream & out)
 		{
-			auto old_array = this->array;
-			this->array.resize(next_prime(2 * old_array.size()));
-			for (auto & entry : this->array)
-			{ // step 1 empty all the elements in the new array. 
-				entry.type = kEmpty;
+			static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<K>::value,
+				"checkpoint needs a trivially copyable T and K");
+			this->finish_resize();
+
+			const auto block_count = (this->array.size() + kDirtyBlock - 1) / kDirtyBlock;
+			checkpoint_header header{};
+			header.magic = kCheckpointMagic;
+			header.version = kSnapshotVersion;
+			header.entry_size = sizeof(entry);
+			header.slot_count = this->array.size();
+			header.entry_count = this->current_size;
+			header.deleted_count = this->deleted_size;
+			for (std::size_t block = 0; block < block_count; block++)
+			{
+				header.block_count += this->array.is_dirty(block) ? 1 : 0;
 			}
+			out.write(reinterpret_cast<const char *>(&header), sizeof(header));
 
-			// rehash all the inserted items. 
-			for (auto & entry : old_array)
+			std::vector<char> slot_bytes(kDirtyBlock * sizeof(entry));
+			for (std::size_t block = 0; block < block_count && out; block++)
 			{
-				if (entry.type == kActive)
+				if (this->array.is_dirty(block))
 				{
-					this->insert(std::move(entry.element));
-				} // else, the entry is not active, do_nothing();
+					const auto begin = block * kDirtyBlock;
+					const auto end = std::min(begin + kDirtyBlock, this->array.size());
+					for (auto i = begin; i < end; i++)
+					{
+						auto target = slot_bytes.data() + (i - begin) * sizeof(entry);
+						if (this->array.types[i] == kActive)
+						{
+							std::memcpy(target, this->array.slots + i, sizeof(entry));
+						}
+						else
+						{
+							std::memset(target, 0, sizeof(entry));
+						}
+					}
+
+					const std::uint64_t index = block;
+					out.write(reinterpret_cast<const char *>(&index), sizeof(index));
+					out.write(reinterpret_cast<const char *>(this->array.types.data() + begin), end - begin);
+					out.write(slot_bytes.data(), (end - begin) * sizeof(entry));
+				} // else, the block is unchanged since the last checkpoint, do_nothing();
 			}
 
+			if (!out)
+			{
+				throw std::runtime_error("Could not write the checkpoint....");
+			} // else, every dirty block was written, do_nothing();
+			this->array.clean();
+			return static_cast<std::size_t>(header.block_count);
 		}
 
 		/**
-		 * Stores the size fo the hash_table.
+		 * Apply one checkpoint read from the stream. Rebuilding a hash_table means
+		 * applying its checkpoints in the order they were written, starting with
+		 * the first, to a hash_table of the same T, K, Hash, and Policy.
+		 * @param in the binary stream to read from.
+		 * @throws std::runtime_error if the stream fails, or the checkpoint does not follow the
+		 * state of the hash_table, in which case the hash_table is left empty.
 		 */
-		std::size_t hash(const T & value) const
+		void restore_checkpoint(std::istream & in)
 		{
-			static std::hash<T> hash_object;
-			return hash_object(value) % this->array.size();
-		}
-	};
+			static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<K>::value,
+				"restore_checkpoint needs a trivially copyable T and K");
+			checkpoint_header header{};
+			in.read(reinterpret_cast<char *>(&header), sizeof(header));
+			if (!in || header.magic != kCheckpointMagic || header.version != kSnapshotVersion ||
+				header.entry_size != sizeof(entry))
+			{
+				throw std::runtime_error("Not a checkpoint of this hash_table type....");
+			} // else, the blocks are ours, do_nothing();
+
+			const auto slot_count = static_cast<std::size_t>(header.slot_count);
+			const auto block_count = (slot_count + kDirtyBlock - 1) / kDirtyBlock;
+			this->finish_resize();
+			if (slot_count != this->array.size())
+			{
+				if (header.block_count != block_count || Policy::next_size(slot_count) != slot_count)
+				{
+					this->make_empty();
+					throw std::runtime_error("The checkpoint does not follow this hash_table....");
+				} // else, every block is in the checkpoint, do_nothing();
+				slot_array restored(slot_count, this->array.allocator);
+				restored.swap(this->array);
+				this->grow_threshold = this->threshold_for(slot_count);
+			} // else, the blocks are applied to the slots in place, do_nothing();
+
+			std::vector<char> slot_bytes(kDirtyBlock * sizeof(entry));
+			std::vector<entry_type> types(kDirtyBlock);
+			for (std::uint64_t read = 0; read < header.block_count; read++)
+			{
+				std::uint64_t block = 0;
+				in.read(reinterpret_cast<char *>(&block), sizeof(block));
+				const auto begin = static_cast<std::size_t>(block) * kDirtyBlock;
+				const auto end = std::min(begin + kDirtyBlock, slot_count);
+				if (in && block < block_count)
+				{
+					in.read(reinterpret_cast<char *>(types.data()), end - begin);
+					in.read(slot_bytes.data(), (end - begin) * sizeof(entry));
+				} // else, the stream is broken, do_nothing();
+				if (!in || block >= block_count)
+				{
+					this->make_empty();
+					throw std::runtime_error("The checkpoint is truncated....");
+				} // else, the whole block was read, do_nothing();
+
+				for (auto i = begin; i < end; i++)
+				{
+					if (this->array.types[i] == kActive)
+					{
+						this->array.destroy(i, types[i - begin]);
+					} // else, there is nothing to destroy, do_nothing();
+
+					if (types[i - begin] == kActive)
+					{
+						const auto restored = load_bytes<entry>(slot_bytes.data() + (i - begin) * sizeof(entry));
+						this->array.construct(i, this->hasher(restored.key), restored.key, restored.element);
+					}
+					else
+					{
+						this->array.types[i] = types[i - begin];
+					}
+				}
+			}
+			this->current_size = static_cast<std::size_t>(header.entry_count);
+			this->deleted_size = static_cast<std::size_t>(header.deleted_count);
+			this->array.clean();
+		}
+
+		/**
+		 * enum data structure containing the three types.
+		 */
+		enum entry_type : std::uint8_t { kActive, kEmpty, kDeleted };
+
+		/**
+		 * Print every slot of the hash_table, with its state, to the console window.
+		 * @param out the overload of the cout operator.
+		 */
+		void print_slots(std::ostream & out = std::cout) const
+		{
+			for (std::size_t i = 0; i < this->array.size(); i++)
+			{
+				this->print_slot(out, this->array, i);
+			}
+			out << std::endl;
+			if (this->is_resizing())
+			{
+				out << "old: ";
+				for (std::size_t i = 0; i < this->old_array.size(); i++)
+				{
+					this->print_slot(out, this->old_array, i);
+				}
+				out << std::endl;
+			} // else, there is no old array, do_nothing();
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the hash_table throw a length error.
+		 */
+		T & get_key(const K & key)
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the hash_table throw a length error.
+		 */
+		const T & get_key(const K & key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under a key equal to a value of another type.
+		 * If the key does not exist in the hash_table throw a length error.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		T & get_key(const Q & key)
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under a key equal to a value of another type.
+		 * If the key does not exist in the hash_table throw a length error.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		const T & get_key(const Q & key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		* Returns the key of the first entry holding the value.
+		* If the value does not exist in the hash_table throw a length error.
+		*/
+		const K & get_value(const T & value) const
+		{
+			auto found = this->find_value_entry(value);
+			if (found == nullptr)
+			{
+				throw std::length_error("Value not found....");
+			} // else, value exists in the table do_nothing();
+			return found->key;
+		}
+
+		template <bool Const>
+		class basic_iterator;
+
+		/**
+		 * Forward iterators over the active entries, which have public element and
+		 * key members. The key must not be changed through an iterator. Any insert
+		 * or remove, and any operation moving entries while resizing, invalidates them.
+		 */
+		typedef basic_iterator<false> iterator;
+		typedef basic_iterator<true> const_iterator;
+
+		/**
+		 * The first active entry. The entries may be written through the iterators,
+		 * so every block is dirty for the next checkpoint.
+		 */
+		iterator begin()
+		{
+			this->array.touch_all();
+			return iterator(&this->array, this->is_resizing() ? &this->old_array : nullptr);
+		}
+
+		iterator end()
+		{
+			return iterator();
+		}
+
+		const_iterator begin() const
+		{
+			return const_iterator(&this->array, this->is_resizing() ? &this->old_array : nullptr);
+		}
+
+		const_iterator end() const
+		{
+			return const_iterator();
+		}
+
+		const_iterator cbegin() const
+		{
+			return this->begin();
+		}
+
+		const_iterator cend() const
+		{
+			return this->end();
+		}
+
+		/**
+		 * Call the function on every active entry, skipping the free slots
+		 * 16 type bytes at a time. The values may be changed, so every block is
+		 * dirty for the next checkpoint.
+		 * @param function called as function(const K & key, T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function)
+		{
+			this->array.touch_all();
+			for (auto * table : { &this->array, &this->old_array })
+			{
+				for (auto i = next_active(*table, 0, table->size()); i < table->size();
+					i = next_active(*table, i + 1, table->size()))
+				{
+					function(static_cast<const K &>(table->slots[i].key), table->slots[i].element);
+				}
+			}
+		}
+
+		/**
+		 * Call the function on every active entry, see for_each_active.
+		 * @param function called as function(const K & key, const T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function) const
+		{
+			for (const auto * table : { &this->array, &this->old_array })
+			{
+				for (auto i = next_active(*table, 0, table->size()); i < table->size();
+					i = next_active(*table, i + 1, table->size()))
+				{
+					function(static_cast<const K &>(table->slots[i].key),
+						static_cast<const T &>(table->slots[i].element));
+				}
+			}
+		}
+
+		/**
+		 * Call the function on every active entry from several threads, each
+		 * walking its own range of slots, see parallel_for. The function is called
+		 * concurrently and in no particular order, so it must be safe to call from
+		 * many threads and must not change the hash_table.
+		 * @param function called as function(const K & key, const T & value).
+		 * @param threads the number of threads, zero for one per hardware thread.
+		 */
+		template <typename Function>
+		void parallel_for_each(Function function, const unsigned threads = 0) const
+		{
+			for (const auto * table : { &this->array, &this->old_array })
+			{
+				parallel_for(table->size(), [&](const std::size_t begin, const std::size_t end)
+				{
+					for (auto i = next_active(*table, begin, end); i < end; i = next_active(*table, i + 1, end))
+					{
+						function(static_cast<const K &>(table->slots[i].key),
+							static_cast<const T &>(table->slots[i].element));
+					}
+				}, threads);
+			}
+		}
+
+		/**
+		 * Print the hash_table forwards and backwards.
+		 * @param out the stream to print to.
+		 */
+		void print(std::ostream & out = std::cout) const
+		{
+			// Forwards
+			for (const auto * table : { &this->array, &this->old_array })
+			{
+				for (std::size_t i = 0; i < table->size(); i++)
+				{
+					if (table->types[i] == kActive)
+					{
+						out << table->slots[i].key << " | " << table->slots[i].element << '\n';
+					} // else, the slot holds no entry, do_nothing();
+				}
+			}
+
+			// Backwards
+			for (const auto * table : { &this->old_array, &this->array })
+			{
+				for (auto i = table->size(); i-- > 0;)
+				{
+					if (table->types[i] == kActive)
+					{
+						out << table->slots[i].key << " | " << table->slots[i].element << '\n';
+					} // else, the slot holds no entry, do_nothing();
+				}
+			}
+		}
+
+		/**
+		 * Overload the insertion operator for printing of the hash_table.
+		 * @return the hash_table to the command line.
+		 */
+	    friend std::ostream & operator<<(std::ostream & out, const hash_table & rhs)
+	    {
+			rhs.print(out);
+			return out;
+		}
+
+		/**
+		 * Overload the subscript operator to allow the return of the data in the current
+		 * position in the hash_table. Or to allow us to change the data in the current
+		 * position of the hash_table. A missing key is inserted with a default value.
+		 * @param key the current key at the current position in the hash_table.
+		 * @return the value stored under the key.
+		 */
+		T &operator[](const K & key)
+		{
+			return *this->try_emplace(key).first;
+		}
+
+	private:
+		template <typename, typename, typename, typename, typename>
+		friend class cache_table;
+
+		struct entry;
+
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<entry> entry_allocator;
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<entry_type> type_allocator;
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t> code_allocator;
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint64_t> word_allocator;
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint8_t> byte_allocator;
+		typedef std::allocator_traits<entry_allocator> entry_traits;
+
+		/**
+		 * True when every slot keeps the full hash code of its entry, so growing never
+		 * calls the hasher and probes only compare the keys whose hash codes match.
+		 */
+		static constexpr bool kCacheHash = cache_hash_code<K>::value;
+
+		/**
+		 * True when every slot keeps a reference byte for the CLOCK eviction of a cache_table.
+		 */
+		static constexpr bool kReferenceBits = reference_bits<Policy>::value;
+
+		/**
+		 * The number of slots sharing one dirty bit, see checkpoint.
+		 */
+		enum { kDirtyBlock = 64 };
+
+		/**
+		 * The fewest slots moved in parallel when growing, see parallel_rehash_threads.
+		 * A parallel move is split into at most kRehashParts chunks and regions,
+		 * each chunk of at least kRehashChunk old slots.
+		 */
+		enum { kParallelRehashSlots = 1 << 16, kRehashParts = 64, kRehashChunk = 1 << 14 };
+
+		/**
+		 * The slots a moved from hash_table allocates on its next insert, as many as the default constructor.
+		 */
+		enum { kMovedFromSize = 7 };
+
+		/**
+		 * Reset the counts after the arrays were moved out, leaving an empty
+		 * hash_table with no slots whose lookups miss without probing.
+		 */
+		void forget_entries()
+		{
+			this->migrate_position = 0;
+			this->grow_threshold = 0;
+			this->current_size = 0;
+			this->deleted_size = 0;
+		}
+
+		/**
+		 * Build the element or key of an entry. A stateful allocator is handed on to
+		 * a T or K that uses allocators, so a std::pmr::string stored in a
+		 * std::pmr hash_table allocates from the same memory resource.
+		 * @param allocator the allocator of the slot storage.
+		 * @param args the arguments for the constructor.
+		 * @return the new value, built straight in place by the caller.
+		 */
+		template <typename X, typename... Args>
+		static X make_with_allocator(const entry_allocator & allocator, Args &&... args)
+		{
+			if constexpr (std::allocator_traits<Allocator>::is_always_equal::value ||
+				!std::uses_allocator<X, Allocator>::value)
+			{
+				return X(std::forward<Args>(args)...);
+			}
+			else if constexpr (std::is_constructible<X, std::allocator_arg_t, const Allocator &, Args...>::value)
+			{
+				return X(std::allocator_arg, Allocator(allocator), std::forward<Args>(args)...);
+			}
+			else
+			{
+				return X(std::forward<Args>(args)..., Allocator(allocator));
+			}
+		}
+
+		/**
+		 * Create a new struct of type entry for the hash_table, this entry
+		 * will contain an element and key. It is only built while its slot is active.
+		 */
+		struct entry
+		{
+			T element;
+			K key;
+
+			template <typename Q, typename... Args>
+			entry(std::piecewise_construct_t, const entry_allocator & allocator, Q && k, Args &&... args)
+				: element(make_with_allocator<T>(allocator, std::forward<Args>(args)...)),
+				key(make_with_allocator<K>(allocator, std::forward<Q>(k))) { }
+		};
+
+		/**
+		 * The slots of one array. The type of every slot is kept in its own byte,
+		 * apart from the raw storage of the entries, so an empty slot costs one byte
+		 * and builds no T or K, and emptying the array is a memset of the types.
+		 */
+		struct slot_array
+		{
+			/**
+			 * The allocator of the entry storage.
+			 */
+			entry_allocator allocator;
+
+			/**
+			 * The type of every slot, kActive, kEmpty, or kDeleted.
+			 */
+			std::vector<entry_type, type_allocator> types;
+
+			/**
+			 * The hash code of the entry of every slot, only kept when kCacheHash is set.
+			 */
+			std::vector<std::size_t, code_allocator> codes;
+
+			/**
+			 * Set when the entry of the slot was found since the clock hand of a
+			 * cache_table last passed it, only kept when kReferenceBits is set.
+			 */
+			std::vector<std::uint8_t, byte_allocator> referenced;
+
+			/**
+			 * One bit per block of kDirtyBlock slots, set when a slot of the block
+			 * changed since the last checkpoint. A new array starts all dirty.
+			 */
+			std::vector<std::uint64_t, word_allocator> dirty;
+
+			/**
+			 * Raw storage for the entries, parallel to the types, only constructed while active.
+			 */
+			entry * slots{};
+
+			explicit slot_array(const Allocator & alloc)
+				: allocator(alloc), types(type_allocator(alloc)), codes(code_allocator(alloc)),
+				referenced(byte_allocator(alloc)), dirty(word_allocator(alloc)) { }
+
+			slot_array(const std::size_t size, const entry_allocator & alloc)
+				: allocator(alloc), types(size, kEmpty, type_allocator(alloc)),
+				codes(kCacheHash ? size : 0, 0, code_allocator(alloc)),
+				referenced(kReferenceBits ? size : 0, 0, byte_allocator(alloc)),
+				dirty((size + kDirtyBlock * 64 - 1) / (kDirtyBlock * 64), ~std::uint64_t{ 0 }, word_allocator(alloc)),
+				slots(size == 0 ? nullptr : entry_traits::allocate(this->allocator, size)) { }
+
+			slot_array(const slot_array & rhs)
+				: slot_array(rhs.size(), entry_traits::select_on_container_copy_construction(rhs.allocator))
+			{ // a type is only copied once its entry is built, so a throwing copy leaks nothing.
+				if constexpr (std::is_trivially_copyable<entry>::value && !std::uses_allocator<T, Allocator>::value &&
+					!std::uses_allocator<K, Allocator>::value)
+				{ // nothing has to be built, every slot is copied as bytes at once.
+					if (!rhs.empty())
+					{
+						std::memcpy(static_cast<void *>(this->slots), rhs.slots, rhs.size() * sizeof(entry));
+						std::copy(rhs.types.begin(), rhs.types.end(), this->types.begin());
+						std::copy(rhs.codes.begin(), rhs.codes.end(), this->codes.begin());
+						std::copy(rhs.referenced.begin(), rhs.referenced.end(), this->referenced.begin());
+					} // else, there are no slots, do_nothing();
+					return;
+				} // else, every entry is built by its constructors, do_nothing();
+				for (std::size_t i = 0; i < rhs.size(); i++)
+				{
+					if (rhs.types[i] == kActive)
+					{
+						this->construct(i, rhs.code_at(i), rhs.slots[i].key, rhs.slots[i].element);
+					} // else, there is nothing to copy, do_nothing();
+					this->types[i] = rhs.types[i];
+				}
+				std::copy(rhs.referenced.begin(), rhs.referenced.end(), this->referenced.begin());
+			}
+
+			slot_array(slot_array && rhs) noexcept
+				: allocator(rhs.allocator), types(std::move(rhs.types)), codes(std::move(rhs.codes)),
+				referenced(std::move(rhs.referenced)), dirty(std::move(rhs.dirty)), slots(rhs.slots)
+			{
+				rhs.slots = nullptr;
+			}
+
+			slot_array & operator=(slot_array rhs) noexcept
+			{
+				this->swap(rhs);
+				return *this;
+			}
+
+			~slot_array()
+			{
+				this->deallocate();
+			}
+
+			/**
+			 * Swap the slots with another array. As with the standard containers the
+			 * allocators are only swapped when they propagate on swap, and must
+			 * otherwise be equal.
+			 */
+			void swap(slot_array & rhs) noexcept
+			{
+				if constexpr (entry_traits::propagate_on_container_swap::value)
+				{
+					std::swap(this->allocator, rhs.allocator);
+				} // else, the allocators are equal, do_nothing();
+				this->types.swap(rhs.types);
+				this->codes.swap(rhs.codes);
+				this->referenced.swap(rhs.referenced);
+				this->dirty.swap(rhs.dirty);
+				std::swap(this->slots, rhs.slots);
+			}
+
+			std::size_t size() const
+			{
+				return this->types.size();
+			}
+
+			bool empty() const
+			{
+				return this->types.empty();
+			}
+
+			/**
+			 * Determine if the slot may hold the key with this hash code. Without
+			 * cached hash codes every slot may, and only the keys tell.
+			 */
+			bool may_match(const std::size_t position, const std::size_t code) const
+			{
+				if constexpr (kCacheHash)
+				{
+					return this->codes[position] == code;
+				}
+				else
+				{
+					return true;
+				}
+			}
+
+			/**
+			 * The cached hash code of an active slot, only valid when kCacheHash is set.
+			 */
+			std::size_t code_at(const std::size_t position) const
+			{
+				return kCacheHash ? this->codes[position] : 0;
+			}
+
+			/**
+			 * Build the element and key of a slot in place and make it active.
+			 * @param position the slot, which must not be active.
+			 * @param code the hash code of the key, kept when kCacheHash is set.
+			 * @param key the argument for the constructor of the key.
+			 * @param args the arguments for the constructor of the element.
+			 */
+			template <typename Q, typename... Args>
+			void construct(const std::size_t position, const std::size_t code, Q && key, Args &&... args)
+			{
+				this->build(position, code, std::forward<Q>(key), std::forward<Args>(args)...);
+				this->touch(position);
+			}
+
+			/**
+			 * Build a slot as construct does, without marking its block dirty. Only for
+			 * a new array, which starts all dirty, so tasks filling different slots
+			 * never write the same dirty word.
+			 */
+			template <typename Q, typename... Args>
+			void build(const std::size_t position, const std::size_t code, Q && key, Args &&... args)
+			{
+				::new (static_cast<void *>(this->slots + position)) entry(std::piecewise_construct,
+					this->allocator, std::forward<Q>(key), std::forward<Args>(args)...);
+				if constexpr (kCacheHash)
+				{
+					this->codes[position] = code;
+				} // else, the hash code is not kept, do_nothing();
+				if constexpr (kReferenceBits)
+				{
+					this->referenced[position] = 0;
+				} // else, there are no reference bytes, do_nothing();
+				this->types[position] = kActive;
+			}
+
+			/**
+			 * Destroy the entry of an active slot and give the slot a new type.
+			 * @param position the slot, which must be active.
+			 * @param type kEmpty or kDeleted.
+			 */
+			void destroy(const std::size_t position, const entry_type type)
+			{
+				this->slots[position].~entry();
+				this->types[position] = type;
+				this->touch(position);
+			}
+
+			/**
+			 * Mark the block of a slot as changed since the last checkpoint.
+			 */
+			void touch(const std::size_t position)
+			{
+				const auto block = position / kDirtyBlock;
+				this->dirty[block / 64] |= std::uint64_t{ 1 } << (block % 64);
+			}
+
+			/**
+			 * Determine if a block of slots changed since the last checkpoint.
+			 */
+			bool is_dirty(const std::size_t block) const
+			{
+				return (this->dirty[block / 64] >> (block % 64) & 1) != 0;
+			}
+
+			/**
+			 * Mark every block as changed since the last checkpoint.
+			 */
+			void touch_all()
+			{
+				std::fill(this->dirty.begin(), this->dirty.end(), ~std::uint64_t{ 0 });
+			}
+
+			/**
+			 * Mark every block as written by a checkpoint.
+			 */
+			void clean()
+			{
+				std::fill(this->dirty.begin(), this->dirty.end(), std::uint64_t{ 0 });
+			}
+
+			/**
+			 * Destroy every active entry and set every slot to empty.
+			 */
+			void clear()
+			{
+				this->destroy_entries();
+				if (!this->empty())
+				{
+					std::memset(this->types.data(), kEmpty, this->size());
+				} // else, there are no slots, do_nothing();
+				this->touch_all();
+			}
+
+			/**
+			 * Destroy every active entry and give the storage back to the allocator.
+			 */
+			void release()
+			{
+				this->deallocate();
+				decltype(this->types)(this->types.get_allocator()).swap(this->types);
+				decltype(this->codes)(this->codes.get_allocator()).swap(this->codes);
+				decltype(this->referenced)(this->referenced.get_allocator()).swap(this->referenced);
+				decltype(this->dirty)(this->dirty.get_allocator()).swap(this->dirty);
+				this->slots = nullptr;
+			}
+
+		private:
+			void destroy_entries()
+			{
+				if (!std::is_trivially_destructible<entry>::value)
+				{
+					for (std::size_t i = 0; i < this->size(); i++)
+					{
+						if (this->types[i] == kActive)
+						{
+							this->slots[i].~entry();
+						} // else, the slot holds no entry, do_nothing();
+					}
+				} // else, there is nothing to destroy, do_nothing();
+			}
+
+			void deallocate()
+			{
+				this->destroy_entries();
+				if (this->slots != nullptr)
+				{
+					entry_traits::deallocate(this->allocator, this->slots, this->size());
+				} // else, nothing was allocated, do_nothing();
+			}
+		};
+
+		/**
+		 * The first bytes of an image written by save, all fields are checked by
+		 * open_mapped against the hash_table type reading it.
+		 */
+		struct snapshot_header
+		{
+			std::uint64_t magic;
+			std::uint64_t version;
+			std::uint64_t entry_size;
+			std::uint64_t entry_align;
+			std::uint64_t key_size;
+			std::uint64_t value_size;
+			std::uint64_t slot_count;
+			std::uint64_t entry_count;
+			std::uint64_t slots_offset;
+		};
+
+		/**
+		 * "NWACCHT" and a zero byte, it also tells apart an image of the other byte order.
+		 */
+		static constexpr std::uint64_t kSnapshotMagic = 0x005448434341574EULL;
+
+		static constexpr std::uint64_t kSnapshotVersion = 1;
+
+		/**
+		 * Where the slots start in an image, after the header and type bytes, on a cache line boundary.
+		 * @param slot_count the number of slots of the image.
+		 * @return the offset of the first slot from the start of the file.
+		 */
+		static std::size_t snapshot_slots_offset(const std::size_t slot_count)
+		{
+			const std::size_t alignment = alignof(entry) > 64 ? alignof(entry) : 64;
+			const auto types_end = sizeof(snapshot_header) + slot_count;
+			return (types_end + alignment - 1) / alignment * alignment;
+		}
+
+		/**
+		 * The first bytes of a stream written by serialize, followed by entry_count
+		 * records of the key bytes and then the value bytes.
+		 */
+		struct stream_header
+		{
+			std::uint64_t magic;
+			std::uint64_t version;
+			std::uint64_t key_size;
+			std::uint64_t value_size;
+			std::uint64_t entry_count;
+		};
+
+		/**
+		 * The first bytes of a checkpoint, followed by block_count blocks, each its
+		 * index, the type bytes of its slots, and then its slots.
+		 */
+		struct checkpoint_header
+		{
+			std::uint64_t magic;
+			std::uint64_t version;
+			std::uint64_t entry_size;
+			std::uint64_t slot_count;
+			std::uint64_t entry_count;
+			std::uint64_t deleted_count;
+			std::uint64_t block_count;
+		};
+
+		/**
+		 * "NWACCHS" and "NWACCHC" with a zero byte, see kSnapshotMagic.
+		 */
+		static constexpr std::uint64_t kStreamMagic = 0x005348434341574EULL;
+
+		static constexpr std::uint64_t kCheckpointMagic = 0x004348434341574EULL;
+
+		/**
+		 * Copy a trivially copyable value out of a byte buffer with no alignment.
+		 * @param bytes the first byte of the value.
+		 * @return the value.
+		 */
+		template <typename X>
+		static X load_bytes(const char * bytes)
+		{
+			typename std::aligned_storage<sizeof(X), alignof(X)>::type storage;
+			std::memcpy(&storage, bytes, sizeof(X));
+			return *std::launder(reinterpret_cast<X *>(&storage));
+		}
+
+		/**
+		 * Find the first active slot in a range, comparing a control_group of 16
+		 * type bytes at once while a whole group fits before the end.
+		 * @param table the array being walked.
+		 * @param position the first slot to check.
+		 * @param end one past the last slot to check.
+		 * @return the first active slot, or end when there is none.
+		 */
+		static std::size_t next_active(const slot_array & table, std::size_t position, const std::size_t end)
+		{
+			const auto types = reinterpret_cast<const control_byte *>(table.types.data());
+			for (; position + control_group::kWidth <= end; position += control_group::kWidth)
+			{
+				const auto active = control_group(types + position).match(static_cast<control_byte>(kActive));
+				if (active)
+				{
+					return position + active.lowest();
+				} // else, the whole group is free, do_nothing();
+			}
+			for (; position < end; ++position)
+			{
+				if (table.types[position] == kActive)
+				{
+					return position;
+				} // else, the slot is free, do_nothing();
+			}
+			return end;
+		}
+
+		/**
+		 * Print one slot for print_slots, the element only when the slot is active.
+		 */
+		void print_slot(std::ostream & out, const slot_array & table, const std::size_t position) const
+		{
+			if (table.types[position] == kActive)
+			{
+				out << table.slots[position].element;
+			} // else, the slot holds no element, do_nothing();
+			out << " {" << this->get_type(table.types[position]) << "} | ";
+		}
+
+		/**
+		 * Gets the 'status' of the current value in the hash_table.
+		 * The acceptable types are kEmpty, kActive, and kDeleted.
+		 * @param type the type of the slot being checked.
+		 * @return the 'status' of the current value in the hash_table.
+		 */
+		std::string get_type(const entry_type type) const
+		{
+			if (type == kEmpty)
+			{
+				return "E";
+			}
+
+			if (type == kActive)
+			{
+				return "A";
+			}
+
+			return "D";
+		}
+
+	    /**
+		 * The slots of the hash_table, with their is_active types.
+		 */
+		slot_array array;
+
+		/**
+		 * The array entries are being moved out of during an incremental resize, empty otherwise.
+		 */
+		slot_array old_array;
+
+		/**
+		 * The next slot of the old array to move.
+		 */
+		std::size_t migrate_position{};
+
+		/**
+		 * The number of old slots moved per operation, zero to rehash at once.
+		 */
+		std::size_t step_budget{};
+
+		/**
+		 * The number of threads moving the entries when growing, 1 to move them on the calling thread.
+		 */
+		unsigned rehash_threads{ 1 };
+
+		/**
+		 * The max load factor of the array.
+		 */
+		float load_limit{ 0.5f };
+
+		/**
+		 * The number of used slots, entries and tombstones, the array may hold before growing.
+		 */
+		std::size_t grow_threshold{};
+
+		/**
+		 * Overload the size_t operator to be the current size of the hash_table.
+		 */
+		std::size_t current_size{};
+
+		/**
+		 * The number of kDeleted slots in the array, these still lengthen probe sequences.
+		 */
+		std::size_t deleted_size{};
+
+		/**
+		 * The function object hashing the keys.
+		 */
+		Hash hasher;
+
+		/**
+		 * The function object comparing the keys.
+		 */
+		KeyEqual key_equal;
+
+		/**
+		 * The probe and rehash counters behind stats, no-ops unless NWACC_HASH_TABLE_STATS is defined.
+		 */
+		mutable stats_recorder recorder;
+
+		/**
+		 * Checks the active state of the current item in the hash_table.
+		 * @param current_position the value being checked.
+		 * @return true if the current value is active.
+		 * @return false if the current value is inactive.
+		 */
+		bool is_active(std::size_t current_position) const
+		{
+			return this->array.types[current_position] == kActive;
+		}
+
+		/**
+		 * Find the current position of the key in one of the arrays.
+		 * @param table the array being probed.
+		 * @param code the hash code of the key.
+		 * @param key the key whose position is being checked.
+		 * @return the position of the key, or of the empty slot ending its probe sequence.
+		 */
+		template <typename Q>
+		std::size_t find_position(const slot_array & table, const std::size_t code, const Q & key,
+			probe_counter & probes) const
+		{
+			return probe_position(table, this->key_equal, code, key, probes);
+		}
+
+		/**
+		 * Walk the probe sequence of a key over any slots with types, slots, size, and
+		 * may_match, which are the slot_array and the slots of a mapped_table.
+		 * @param table the slots being probed.
+		 * @param equal the key equality function.
+		 * @param code the hash code of the key.
+		 * @param key the key whose position is being checked.
+		 * @param probes counts the slots checked.
+		 * @return the position of the key, or of the empty slot ending its probe sequence.
+		 */
+		template <typename Table, typename Q>
+		static std::size_t probe_position(const Table & table, const KeyEqual & equal, const std::size_t code,
+			const Q & key, probe_counter & probes)
+		{
+			std::size_t off_set = 1;
+			auto current_position = Policy::index(code, table.size());
+
+			while (table.types[current_position] != kEmpty &&
+				!(table.types[current_position] == kActive && table.may_match(current_position, code) &&
+					equal(table.slots[current_position].key, key)))
+			{
+				current_position = Policy::probe(current_position, off_set, table.size());
+				probes.add();
+			}
+			return current_position;
+		}
+
+		/**
+		 * Find the slot of the key in the array, or the slot a new entry for the
+		 * key should go in. The first deleted slot of the probe sequence is reused
+		 * so tombstones do not pile up under insert and remove churn.
+		 * @param code the hash code of the key.
+		 * @param key the key whose position is being checked.
+		 * @param probes counts the slots checked.
+		 * @return the position of the active key, or of the slot to insert it in.
+		 */
+		template <typename Q>
+		std::size_t find_insert_position(const std::size_t code, const Q & key, probe_counter & probes) const
+		{
+			std::size_t off_set = 1;
+			auto current_position = Policy::index(code, this->array.size());
+			auto first_deleted = this->array.size();
+
+			while (this->array.types[current_position] != kEmpty)
+			{
+				if (this->array.types[current_position] == kActive)
+				{
+					if (this->array.may_match(current_position, code) &&
+						this->key_equal(this->array.slots[current_position].key, key))
+					{
+						return current_position;
+					} // else, a different key, do_nothing();
+				}
+				else if (first_deleted == this->array.size())
+				{
+					first_deleted = current_position;
+				} // else, an earlier tombstone was already seen, do_nothing();
+				current_position = Policy::probe(current_position, off_set, this->array.size());
+				probes.add();
+			}
+			return first_deleted == this->array.size() ? current_position : first_deleted;
+		}
+
+		/**
+		 * Find the active entry stored under the key, in the old array too while resizing.
+		 * @param key the key being searched for.
+		 * @return the entry of the key, or nullptr when it is missing.
+		 */
+		template <typename Q>
+		const entry * find_entry(const Q & key) const
+		{
+			return this->find_entry(this->hasher(key), key);
+		}
+
+		/**
+		 * Find the active entry stored under the key, for a hash code worked out already.
+		 * @param code the hash code of the key.
+		 * @param key the key being searched for.
+		 * @return the entry of the key, or nullptr when it is missing.
+		 */
+		template <typename Q>
+		const entry * find_entry(const std::size_t code, const Q & key) const
+		{
+			if (this->array.empty())
+			{ // a moved from hash_table has no slots, and no old array either.
+				return nullptr;
+			} // else, there are slots to probe, do_nothing();
+			probe_counter probes;
+			auto current_position = this->find_position(this->array, code, key, probes);
+			if (this->array.types[current_position] == kActive)
+			{
+				this->recorder.record_hit(probes);
+				return &this->array.slots[current_position];
+			} // else, not in the current array, do_nothing();
+
+			if (this->is_resizing())
+			{
+				probes.add();
+				current_position = this->find_position(this->old_array, code, key, probes);
+				if (this->old_array.types[current_position] == kActive)
+				{
+					this->recorder.record_hit(probes);
+					return &this->old_array.slots[current_position];
+				} // else, not moved yet either, do_nothing();
+			} // else, there is no old array, do_nothing();
+			this->recorder.record_miss(probes);
+			return nullptr;
+		}
+
+		/**
+		 * Find the active entry stored under the key, in the old array too while resizing.
+		 * @param key the key being searched for.
+		 * @return the entry of the key, or nullptr when it is missing.
+		 */
+		template <typename Q>
+		entry * find_entry(const Q & key)
+		{ // the entry may be written through the pointer, so its block is dirty for the next checkpoint.
+			const auto found = const_cast<entry *>(static_cast<const hash_table *>(this)->find_entry(key));
+			if (found != nullptr && this->is_in_array(found))
+			{
+				const auto position = static_cast<std::size_t>(found - this->array.slots);
+				this->array.touch(position);
+				if constexpr (kReferenceBits)
+				{ // a hit of a cache_table, the clock hand gives the entry a second chance.
+					this->array.referenced[position] = 1;
+				} // else, there are no reference bytes, do_nothing();
+			} // else, the entry is marked dirty once it is moved into the array, do_nothing();
+			return found;
+		}
+
+		/**
+		 * Order the indexes of the hash codes by the part of the array their home
+		 * bucket falls in, with one stable counting sort pass, so the entries of a
+		 * bulk insert are placed walking the array from front to back, and repeated
+		 * keys keep the order they were given in.
+		 * @param codes the hash codes of the keys.
+		 * @return the indexes of the codes, sorted by home bucket.
+		 */
+		std::vector<std::size_t> partition_by_home(const std::vector<std::size_t> & codes) const
+		{
+			const auto size = this->array.size();
+			const auto partitions = std::min<std::size_t>(size, std::size_t{ 1 } << 12);
+			const auto partition_of = [&](const std::size_t code)
+			{
+				return static_cast<std::size_t>(
+					static_cast<unsigned long long>(Policy::index(code, size)) * partitions / size);
+			};
+
+			std::vector<std::size_t> starts(partitions + 1);
+			for (const auto code : codes)
+			{
+				++starts[partition_of(code) + 1];
+			}
+			for (std::size_t i = 1; i <= partitions; i++)
+			{
+				starts[i] += starts[i - 1];
+			}
+
+			std::vector<std::size_t> order(codes.size());
+			for (std::size_t i = 0; i < codes.size(); i++)
+			{
+				order[starts[partition_of(codes[i])]++] = i;
+			}
+			return order;
+		}
+
+		/**
+		 * The number of keys hashed and prefetched together by the batch lookups.
+		 */
+		enum { kBatchChunk = 32 };
+
+		/**
+		 * Look up the keys a chunk at a time: hash the chunk, prefetch the type byte and
+		 * the entry of every home slot, then probe each key.
+		 * @param keys the keys being searched for.
+		 * @param count the number of keys.
+		 * @param report called with the index of each key and its entry, or nullptr.
+		 */
+		template <typename Report>
+		void lookup_batch(const K * keys, const std::size_t count, Report && report) const
+		{
+			if (this->array.empty())
+			{ // a moved from hash_table has no home slots to prefetch, every key is missing.
+				for (std::size_t i = 0; i < count; i++)
+				{
+					report(i, nullptr);
+				}
+				return;
+			} // else, there are slots to probe, do_nothing();
+
+			std::size_t codes[kBatchChunk];
+			for (std::size_t first = 0; first < count; first += kBatchChunk)
+			{
+				const auto chunk = std::min<std::size_t>(kBatchChunk, count - first);
+				for (std::size_t i = 0; i < chunk; i++)
+				{
+					codes[i] = this->hasher(keys[first + i]);
+					const auto home = Policy::index(codes[i], this->array.size());
+					prefetch(this->array.types.data() + home);
+					prefetch(this->array.slots + home);
+				}
+				for (std::size_t i = 0; i < chunk; i++)
+				{
+					report(first + i, this->find_entry(codes[i], keys[first + i]));
+				}
+			}
+		}
+
+		/**
+		 * Remove the entry stored under the key.
+		 * @param key the key, or a value comparable with the keys.
+		 * @return true if an entry was removed.
+		 */
+		template <typename Q>
+		bool remove_key(const Q & key)
+		{
+			this->migrate_step();
+			auto found = this->find_entry(key);
+			if (found == nullptr)
+			{
+				return false;
+			}
+			else
+			{
+				this->erase_entry(found);
+				return true;
+			}
+		}
+
+		/**
+		 * Find the first active entry holding the value, in both arrays.
+		 * @param value the value being searched for.
+		 * @return the entry holding the value, or nullptr when it is missing.
+		 */
+		const entry * find_value_entry(const T & value) const
+		{
+			for (const auto * table : { &this->array, &this->old_array })
+			{
+				for (std::size_t i = 0; i < table->size(); i++)
+				{
+					if (table->types[i] == kActive && table->slots[i].element == value)
+					{
+						return &table->slots[i];
+					} // else, keep looking, do_nothing();
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Insert or replace the entry stored under the key.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the hash_table.
+		 */
+		template <typename V, typename Q>
+		bool insert_entry(V && value, Q && key)
+		{
+			return this->assign_entry(std::forward<Q>(key), std::forward<V>(value)).second;
+		}
+
+		/**
+		 * Insert the value under the key, or assign it to the value already stored under the key.
+		 * @param key the key to be inserted.
+		 * @param value the data to be inserted or assigned.
+		 * @return the stored value, and true if a new entry was inserted.
+		 */
+		template <typename Q, typename V>
+		std::pair<T *, bool> assign_entry(Q && key, V && value)
+		{
+			const auto result = this->emplace_entry(std::forward<Q>(key), std::forward<V>(value));
+			if (!result.second)
+			{ // the value was not used to build a new entry, so it is still ours to assign.
+				result.first->element = std::forward<V>(value);
+			} // else, the value was moved into the new entry, do_nothing();
+			return { &result.first->element, result.second };
+		}
+
+		/**
+		 * Find the entry of the key, building a new one in place from the arguments
+		 * when the key is missing. The arguments are left untouched when the key is found.
+		 * @param key the key, or the argument for the constructor of the key.
+		 * @param args the arguments for the constructor of the element.
+		 * @return the entry of the key, and true if it was just built.
+		 */
+		template <typename Q, typename... Args>
+		std::pair<entry *, bool> emplace_entry(Q && key, Args &&... args)
+		{
+			this->migrate_step();
+			if (this->array.empty())
+			{ // a moved from hash_table allocates its slots again.
+				this->rehash_to(Policy::next_size(kMovedFromSize), false);
+			} // else, the array is allocated, do_nothing();
+			const auto code = this->hasher(key);
+			probe_counter probes;
+			auto current_position = this->find_insert_position(code, key, probes);
+			if (this->is_active(current_position))
+			{
+				this->array.touch(current_position);
+				return { &this->array.slots[current_position], false };
+			} // else, not in the current array, do_nothing();
+
+			if (this->is_resizing())
+			{
+				probe_counter old_probes;
+				const auto old_position = this->find_position(this->old_array, code, key, old_probes);
+				if (this->old_array.types[old_position] == kActive)
+				{
+					return { &this->old_array.slots[old_position], false };
+				} // else, the key is new, do_nothing();
+			} // else, there is no old array, do_nothing();
+
+			if (this->array.types[current_position] != kDeleted &&
+				this->current_size + this->deleted_size + 1 > this->grow_threshold)
+			{ // the entry would take the array past the max load factor, counting the tombstones.
+				this->grow();
+				probes = probe_counter();
+				current_position = this->find_insert_position(code, key, probes);
+			} // else we are within the load factor do_nothing();
+			this->recorder.record_insert(probes);
+
+			const auto reused = this->array.types[current_position] == kDeleted;
+			this->array.construct(current_position, code, std::forward<Q>(key), std::forward<Args>(args)...);
+			if (reused)
+			{
+				--this->deleted_size;
+			} // else, an empty slot is used, do_nothing();
+			++this->current_size;
+
+			return { &this->array.slots[current_position], true };
+		}
+
+		/**
+		 * Mark an active entry deleted and update the counts.
+		 * @param found the entry being removed, from either array.
+		 */
+		void erase_entry(entry * found)
+		{
+			const auto in_array = this->is_in_array(found);
+			auto & table = in_array ? this->array : this->old_array;
+			table.destroy(static_cast<std::size_t>(found - table.slots), kDeleted);
+			--this->current_size;
+			if (in_array)
+			{
+				++this->deleted_size;
+			} // else, the tombstones of the old array go away with it, do_nothing();
+		}
+
+		/**
+		 * Determine if an entry lives in the current array rather than the old one.
+		 */
+		bool is_in_array(const entry * place) const
+		{
+			const std::less<const entry *> before;
+			return !before(place, this->array.slots) && before(place, this->array.slots + this->array.size());
+		}
+
+		/**
+		 * The number of used slots an array of the given size may hold under the
+		 * max load factor, always leaving at least one empty slot to end probes.
+		 */
+		std::size_t threshold_for(const std::size_t size) const
+		{
+			return std::min(static_cast<std::size_t>(size * static_cast<double>(this->load_limit)), size - 1);
+		}
+
+		/**
+		 * The capacity needed to hold the given number of entries under the max load factor.
+		 */
+		std::size_t slots_for(const std::size_t count) const
+		{
+			auto slots = static_cast<std::size_t>(std::ceil(count / static_cast<double>(this->load_limit)));
+			while (this->threshold_for(slots) < count)
+			{ // make up for rounding in the load factor.
+				++slots;
+			}
+			return Policy::next_size(slots);
+		}
+
+		/**
+		 * Resize the hash_table to be a more appropriate size for the data being inserted.
+		 * Called before an insert that would cross the max load factor, so the array
+		 * being drained by an incremental resize always keeps an empty slot.
+		 * When at most half of the used slots hold entries, the load factor was crossed
+		 * because of tombstones, and the array is rebuilt at the same size to drop them.
+		 * With a resize step budget the entries are moved a few at a time by the
+		 * following operations.
+		 */
+		void grow()
+		{
+			const auto new_size = this->current_size * 2 <= this->grow_threshold
+				? this->array.size()
+				: Policy::next_size(2 * this->array.size());
+			this->rehash_to(new_size, this->step_budget != 0);
+		}
+
+		/**
+		 * Rebuild the hash_table with the given number of slots.
+		 * The old array is swapped out and every active entry is moved, never copied,
+		 * straight into its new slot, then the old array is released.
+		 * @param new_size the capacity of the new array.
+		 * @param incremental true to leave the moves to the following operations.
+		 */
+		void rehash_to(const std::size_t new_size, const bool incremental)
+		{
+			const auto threads = this->rehash_threads != 0 ? this->rehash_threads : std::thread::hardware_concurrency();
+			if (!incremental && threads > 1 && this->array.size() >= kParallelRehashSlots)
+			{
+				this->parallel_rehash_to(new_size, thread_executor{ threads });
+				return;
+			} // else, the entries are moved on this thread, do_nothing();
+
+			this->finish_resize();
+			slot_array old(new_size, this->array.allocator);
+			old.swap(this->array);
+			this->deleted_size = 0;
+			this->grow_threshold = this->threshold_for(new_size);
+			this->recorder.record_rehash();
+
+			if (!incremental)
+			{ // move all the inserted items, the new array starts out empty.
+				const auto start = this->recorder.now();
+				for (std::size_t i = 0; i < old.size(); i++)
+				{
+					if (old.types[i] == kActive)
+					{
+						this->place(this->code_at(old, i), std::move(old.slots[i]));
+					} // else, the entry is not active, do_nothing();
+				}
+				this->recorder.record_rehash_time(start);
+			}
+			else
+			{
+				this->old_array.swap(old);
+				this->migrate_position = 0;
+				this->migrate_step();
+			}
+		}
+
+		/**
+		 * Rebuild the hash_table with the given number of slots, moving the entries
+		 * on the tasks of the executor, see parallel_rehash.
+		 * @param new_size the capacity of the new array.
+		 * @param executor runs the tasks, see thread_executor.
+		 */
+		template <typename Executor>
+		void parallel_rehash_to(const std::size_t new_size, Executor && executor)
+		{
+			this->finish_resize();
+			slot_array old(new_size, this->array.allocator);
+			old.swap(this->array);
+			this->deleted_size = 0;
+			this->grow_threshold = this->threshold_for(new_size);
+			this->recorder.record_rehash();
+
+			const auto start = this->recorder.now();
+			const auto parts = std::max<std::size_t>(1, std::min<std::size_t>(kRehashParts, old.size() / kRehashChunk));
+			const auto chunk_size = (old.size() + parts - 1) / parts;
+			const auto region_size = (new_size + parts - 1) / parts;
+			const auto region_of = [&](const std::size_t position)
+			{
+				return Policy::index(this->code_at(old, position), new_size) / region_size;
+			};
+
+			// count the entries of every chunk headed for every region.
+			std::vector<std::size_t> cursors(parts * parts);
+			executor(parts, [&](const std::size_t chunk)
+			{
+				const auto end = std::min(old.size(), (chunk + 1) * chunk_size);
+				for (auto i = next_active(old, chunk * chunk_size, end); i < end; i = next_active(old, i + 1, end))
+				{
+					++cursors[chunk * parts + region_of(i)];
+				}
+			});
+
+			// lay the regions out one after the other, each with the entries of chunk 0 first.
+			std::vector<std::size_t> bounds(parts + 1);
+			for (std::size_t region = 0; region < parts; region++)
+			{
+				bounds[region + 1] = bounds[region];
+				for (std::size_t chunk = 0; chunk < parts; chunk++)
+				{
+					const auto count = cursors[chunk * parts + region];
+					cursors[chunk * parts + region] = bounds[region + 1];
+					bounds[region + 1] += count;
+				}
+			}
+
+			std::vector<std::size_t> sorted(bounds[parts]);
+			executor(parts, [&](const std::size_t chunk)
+			{
+				const auto end = std::min(old.size(), (chunk + 1) * chunk_size);
+				for (auto i = next_active(old, chunk * chunk_size, end); i < end; i = next_active(old, i + 1, end))
+				{
+					sorted[cursors[chunk * parts + region_of(i)]++] = i;
+				}
+			});
+
+			// every region is filled by one task, an entry probing out of its region is left for later.
+			std::vector<std::vector<std::size_t>> spilled(parts);
+			executor(parts, [&](const std::size_t region)
+			{
+				const auto low = region * region_size;
+				const auto high = std::min(new_size, low + region_size);
+				for (auto i = bounds[region]; i < bounds[region + 1]; i++)
+				{
+					const auto code = this->code_at(old, sorted[i]);
+					std::size_t off_set = 1;
+					auto current_position = Policy::index(code, new_size);
+					while (current_position >= low && current_position < high &&
+						this->array.types[current_position] == kActive)
+					{
+						current_position = Policy::probe(current_position, off_set, new_size);
+					}
+
+					if (current_position >= low && current_position < high)
+					{
+						auto & moved = old.slots[sorted[i]];
+						this->array.build(current_position, code, std::move(moved.key), std::move(moved.element));
+					}
+					else
+					{
+						spilled[region].push_back(sorted[i]);
+					}
+				}
+			});
+
+			for (const auto & left : spilled)
+			{
+				for (const auto position : left)
+				{
+					this->place(this->code_at(old, position), std::move(old.slots[position]));
+				}
+			}
+			this->recorder.record_rehash_time(start);
+		}
+
+		/**
+		 * Move the next resize step budget worth of old slots, if a resize is running.
+		 */
+		void migrate_step()
+		{
+			if (this->is_resizing())
+			{
+				this->migrate(this->step_budget);
+			} // else, no resize is running, do_nothing();
+		}
+
+		/**
+		 * Move the active entries of the next slots of the old array into the
+		 * current one, and release the old array once it has been walked.
+		 * A moved slot is marked deleted so the probe sequences of the entries
+		 * still waiting in the old array keep working.
+		 * @param count the number of old slots to walk.
+		 */
+		void migrate(const std::size_t count)
+		{
+			const auto start = this->recorder.now();
+			const auto end = std::min(this->old_array.size(), this->migrate_position + count);
+			for (; this->migrate_position < end; ++this->migrate_position)
+			{
+				if (this->old_array.types[this->migrate_position] == kActive)
+				{
+					this->place(this->code_at(this->old_array, this->migrate_position),
+						std::move(this->old_array.slots[this->migrate_position]));
+					this->old_array.destroy(this->migrate_position, kDeleted);
+				} // else, the entry is not active, do_nothing();
+			}
+
+			if (this->migrate_position == this->old_array.size())
+			{
+				this->old_array.release();
+				this->migrate_position = 0;
+			} // else, there are slots left to move, do_nothing();
+			this->recorder.record_rehash_time(start);
+		}
+
+		/**
+		 * The hash code of an active slot, read from the slot when it is cached.
+		 */
+		std::size_t code_at(const slot_array & table, const std::size_t position) const
+		{
+			if constexpr (kCacheHash)
+			{
+				return table.codes[position];
+			}
+			else
+			{
+				return this->hasher(table.slots[position].key);
+			}
+		}
+
+		/**
+		 * Move an active entry into the first free slot of its probe sequence.
+		 * Only used for keys known to be missing from the array, so no lookup
+		 * or size bookkeeping is needed, and the first tombstone met can be reused.
+		 * @param code the hash code of the key of the entry.
+		 * @param moved the entry being moved into the array.
+		 */
+		void place(const std::size_t code, entry && moved) noexcept(std::allocator_traits<Allocator>::is_always_equal::value &&
+			std::is_nothrow_move_constructible<T>::value &&
+			std::is_nothrow_move_constructible<K>::value)
+		{
+			std::size_t off_set = 1;
+			auto current_position = Policy::index(code, this->array.size());
+			while (this->array.types[current_position] == kActive)
+			{
+				current_position = Policy::probe(current_position, off_set, this->array.size());
+			}
+			if (this->array.types[current_position] == kDeleted)
+			{
+				--this->deleted_size;
+			} // else, an empty slot is used, do_nothing();
+			this->array.construct(current_position, code, std::move(moved.key), std::move(moved.element));
+		}
+	};
+
+	/**
+	 * A forward iterator over the active entries of a hash_table, the slots of
+	 * the current array and then those of the old array while resizing.
+	 * @tparam Const true for a const_iterator.
+	 */
+	template <typename T, typename K, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+	template <bool Const>
+	class hash_table<T, K, Hash, KeyEqual, Policy, Allocator>::basic_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef entry value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef typename std::conditional<Const, const entry *, entry *>::type pointer;
+		typedef typename std::conditional<Const, const entry &, entry &>::type reference;
+
+		/**
+		 * The end iterator.
+		 */
+		basic_iterator() = default;
+
+		/**
+		 * An iterator can always be made const.
+		 */
+		operator basic_iterator<true>() const
+		{
+			return basic_iterator<true>(this->table, this->next, this->position);
+		}
+
+		reference operator*() const
+		{
+			return this->table->slots[this->position];
+		}
+
+		pointer operator->() const
+		{
+			return this->table->slots + this->position;
+		}
+
+		basic_iterator & operator++()
+		{
+			this->position = next_active(*this->table, this->position + 1, this->table->size());
+			this->settle();
+			return *this;
+		}
+
+		basic_iterator operator++(int)
+		{
+			auto copy = *this;
+			++*this;
+			return copy;
+		}
+
+		friend bool operator==(const basic_iterator & lhs, const basic_iterator & rhs)
+		{
+			return lhs.table == rhs.table && lhs.position == rhs.position;
+		}
+
+		friend bool operator!=(const basic_iterator & lhs, const basic_iterator & rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+		friend class hash_table;
+		friend class basic_iterator<!Const>;
+
+		/**
+		 * Start at the first active slot of the array, moving on to the next array, if any, after it.
+		 */
+		basic_iterator(const slot_array * first, const slot_array * second)
+			: table(first), next(second), position(next_active(*first, 0, first->size()))
+		{
+			this->settle();
+		}
+
+		basic_iterator(const slot_array * current, const slot_array * second, const std::size_t at)
+			: table(current), next(second), position(at) { }
+
+		/**
+		 * Move past the end of a walked array, to the next array or to the end iterator.
+		 */
+		void settle()
+		{
+			while (this->table != nullptr && this->position == this->table->size())
+			{
+				this->table = this->next;
+				this->next = nullptr;
+				this->position = this->table == nullptr ? 0 : next_active(*this->table, 0, this->table->size());
+			}
+		}
+
+		const slot_array * table{};
+		const slot_array * next{};
+		std::size_t position{};
+	};
+
+	/**
+	 * A read only hash_table over an image written by hash_table::save and mapped
+	 * into memory with hash_table::open_mapped. The type bytes and slots of the
+	 * image are probed where they lie in the mapping, so opening costs no reads
+	 * and the pages of a lookup are only loaded when it touches them.
+	 * The mapping is released when the mapped_table is destroyed, after which
+	 * the pointers handed out by find are no longer valid.
+	 */
+	template <typename T, typename K, typename Hash, typename KeyEqual, typename Policy, typename Allocator>
+	class hash_table<T, K, Hash, KeyEqual, Policy, Allocator>::mapped_table
+	{
+	public:
+		/**
+		 * Check the image and set up its slots.
+		 * @param file the mapped image.
+		 * @param hash the hash function.
+		 * @param equal the key equality function.
+		 * @throws std::runtime_error if the file is not an image of this hash_table type.
+		 */
+		mapped_table(mapped_file file, const Hash & hash, const KeyEqual & equal)
+			: file(std::move(file)), hasher(hash), key_equal(equal)
+		{
+			static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<K>::value,
+				"open_mapped needs a trivially copyable T and K");
+			if (this->file.size() < sizeof(snapshot_header))
+			{
+				throw std::runtime_error("Not a hash_table image....");
+			} // else, there is a header, do_nothing();
+
+			snapshot_header header;
+			std::memcpy(&header, this->file.data(), sizeof(header));
+			if (header.magic != kSnapshotMagic || header.version != kSnapshotVersion)
+			{
+				throw std::runtime_error("Not a hash_table image....");
+			} // else, the header is ours, do_nothing();
+
+			if (header.entry_size != sizeof(entry) || header.entry_align != alignof(entry) ||
+				header.key_size != sizeof(K) || header.value_size != sizeof(T))
+			{
+				throw std::runtime_error("The image holds different key or value types....");
+			} // else, the slots have the layout of this table, do_nothing();
+
+			const auto slot_count = static_cast<std::size_t>(header.slot_count);
+			if (slot_count == 0 || Policy::next_size(slot_count) != slot_count ||
+				header.slots_offset != snapshot_slots_offset(slot_count) ||
+				(this->file.size() - header.slots_offset) / sizeof(entry) < slot_count)
+			{
+				throw std::runtime_error("The image is truncated or of another Policy....");
+			} // else, every slot is in the file, do_nothing();
+
+			this->slots_view.types = reinterpret_cast<const entry_type *>(this->file.data() + sizeof(snapshot_header));
+			this->slots_view.slots = reinterpret_cast<const entry *>(this->file.data() + header.slots_offset);
+			this->slots_view.count = slot_count;
+			this->entry_count = static_cast<std::size_t>(header.entry_count);
+		}
+
+		/**
+		 * Determine if the image contains an entry with a matching key.
+		 */
+		bool contains(const K & key) const
+		{
+			return this->find(key) != nullptr;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value inside the mapping, or nullptr when the key is missing.
+		 */
+		const T * find(const K & key) const
+		{
+			probe_counter probes;
+			const auto position = probe_position(this->slots_view, this->key_equal, this->hasher(key), key, probes);
+			return this->slots_view.types[position] == kActive ? &this->slots_view.slots[position].element : nullptr;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the image throw a length error.
+		 */
+		const T & get_key(const K & key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * The number of entries in the image.
+		 */
+		std::size_t size() const
+		{
+			return this->entry_count;
+		}
+
+	private:
+		/**
+		 * The type bytes and slots of the image, probed the same way as a slot_array.
+		 */
+		struct mapped_slots
+		{
+			const entry_type * types{};
+			const entry * slots{};
+			std::size_t count{};
+
+			std::size_t size() const
+			{
+				return this->count;
+			}
+
+			bool may_match(const std::size_t, const std::size_t) const
+			{
+				return true;
+			}
+		};
+
+		mapped_file file;
+		mapped_slots slots_view;
+		std::size_t entry_count{};
+		Hash hasher;
+		KeyEqual key_equal;
+	};
+
+	namespace pmr {
+
+		/**
+		 * A hash_table whose slots, and std::pmr strings and containers stored in
+		 * it, come from a std::pmr::memory_resource.
+		 */
+		template <typename T, typename K,
+			typename Hash = std::hash<K>,
+			typename KeyEqual = std::equal_to<K>,
+			typename Policy = power_of_two_policy>
+		using hash_table = nwacc::hash_table<T, K, Hash, KeyEqual, Policy, std::pmr::polymorphic_allocator<T>>;
+	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,601 @@
+#ifndef INTEGER_HASH_TABLE_H_
+#define INTEGER_HASH_TABLE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hash_policy.h"
+
+namespace nwacc {
+
+	/**
+	 * Detect a key type that is a plain integer or enum, other than bool, so a
+	 * table can keep its keys in a flat array and mark free slots with reserved
+	 * key values.
+	 */
+	template <typename K>
+	struct is_integer_key : std::integral_constant<bool,
+		(std::is_integral<K>::value || std::is_enum<K>::value) && !std::is_same<K, bool>::value> { };
+
+	/**
+	 * Detect an entry that integer_hash_table can store, an integer key and a
+	 * value that is copied as bytes.
+	 */
+	template <typename T, typename K>
+	struct is_compact_entry : std::integral_constant<bool,
+		is_integer_key<K>::value && std::is_trivially_copyable<T>::value> { };
+
+	/**
+	 * Hash of an integer key with one multiply between two xor shifts. The high
+	 * bits of the key reach the low bits used to pick a bucket, so the code is
+	 * used as it is, without the mix of the hash_table policies.
+	 */
+	template <typename K>
+	struct integer_hash
+	{
+		std::size_t operator()(const K key) const
+		{
+			auto bits = static_cast<std::uint64_t>(key);
+			bits ^= bits >> 32;
+			bits *= 0xd6e8feb86659fd93ULL;
+			bits ^= bits >> 32;
+			return static_cast<std::size_t>(bits);
+		}
+	};
+
+	/**
+	 * Open addressing hash table of trivially copyable values T stored under
+	 * integer keys K, for maps such as std::uint64_t ids to std::uint32_t
+	 * indexes. The keys and the values are kept in two flat arrays instead of
+	 * an array of entries, and a free slot is marked by a reserved key value
+	 * instead of a type byte, so a std::uint64_t to std::uint32_t slot takes 12
+	 * bytes and a probe reads only the keys. Growing and copying are plain
+	 * copies of keys and values. The two reserved key values, every bit set
+	 * and every bit but the lowest set, may still be inserted, their entries
+	 * are kept aside from the arrays. Linear probing on a power of two size.
+	 * Offers the key side of the hash_table interface.
+	 * @tparam Hash the function object hashing a key, its code is used as is
+	 * to pick a bucket, so it must spread every bit of the key.
+	 */
+	template <typename T, typename K,
+		typename Hash = integer_hash<K>>
+	class integer_hash_table
+	{
+		static_assert(is_integer_key<K>::value, "integer_hash_table needs an integer or enum key");
+		static_assert(std::is_trivially_copyable<T>::value, "integer_hash_table needs a trivially copyable value");
+
+	public:
+		/**
+		 * Create a new integer_hash_table with at least the given number of slots.
+		 * @param size the number of slots to allocate.
+		 * @param hash the function object hashing a key.
+		 */
+		explicit integer_hash_table(std::size_t size = 8, const Hash & hash = Hash())
+			: hasher(hash)
+		{
+			this->allocate(power_of_two_policy::next_size(size));
+		}
+
+		integer_hash_table(const integer_hash_table & rhs)
+			: current_size(rhs.current_size), deleted_size(rhs.deleted_size), load_limit(rhs.load_limit),
+			hasher(rhs.hasher)
+		{
+			this->allocate(rhs.capacity);
+			if (rhs.capacity != 0)
+			{
+				std::memcpy(this->keys, rhs.keys, rhs.capacity * sizeof(K));
+				std::memcpy(static_cast<void *>(this->values), rhs.values, rhs.capacity * sizeof(T));
+			} // else, rhs was moved from and has no arrays, do_nothing();
+			std::copy(std::begin(rhs.reserved), std::end(rhs.reserved), std::begin(this->reserved));
+		}
+
+		/**
+		 * Move the entries of another integer_hash_table, which is left with no
+		 * slots and allocates again on its next insert or reserve.
+		 */
+		integer_hash_table(integer_hash_table && rhs) noexcept
+			: keys(rhs.keys), values(rhs.values), capacity(rhs.capacity), current_size(rhs.current_size),
+			deleted_size(rhs.deleted_size), load_limit(rhs.load_limit), grow_threshold(rhs.grow_threshold),
+			hasher(std::move(rhs.hasher))
+		{
+			std::copy(std::begin(rhs.reserved), std::end(rhs.reserved), std::begin(this->reserved));
+			rhs.keys = nullptr;
+			rhs.values = nullptr;
+			rhs.capacity = 0;
+			rhs.current_size = 0;
+			rhs.deleted_size = 0;
+			rhs.grow_threshold = 0;
+			rhs.reserved[0].reset();
+			rhs.reserved[1].reset();
+		}
+
+		integer_hash_table & operator=(integer_hash_table rhs) noexcept
+		{
+			this->swap(rhs);
+			return *this;
+		}
+
+		~integer_hash_table()
+		{
+			this->deallocate();
+		}
+
+		/**
+		 * Exchange the contents of two integer_hash_tables.
+		 */
+		void swap(integer_hash_table & rhs) noexcept
+		{
+			using std::swap;
+			swap(this->keys, rhs.keys);
+			swap(this->values, rhs.values);
+			swap(this->capacity, rhs.capacity);
+			swap(this->current_size, rhs.current_size);
+			swap(this->deleted_size, rhs.deleted_size);
+			swap(this->load_limit, rhs.load_limit);
+			swap(this->grow_threshold, rhs.grow_threshold);
+			swap(this->hasher, rhs.hasher);
+			swap(this->reserved, rhs.reserved);
+		}
+
+		/**
+		 * Determine if the integer_hash_table contains an entry with a matching key.
+		 */
+		bool contains(const K key) const
+		{
+			return this->find(key) != nullptr;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const K key)
+		{
+			return const_cast<T *>(static_cast<const integer_hash_table *>(this)->find(key));
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const K key) const
+		{
+			if (is_reserved(key))
+			{
+				const auto & aside = this->reserved[reserved_index(key)];
+				return aside ? &*aside : nullptr;
+			} // else, the key lives in the arrays, do_nothing();
+
+			const auto current_position = this->find_position(key);
+			return current_position == this->capacity ? nullptr : this->values + current_position;
+		}
+
+		/**
+		 * Remove every entry, keeping the allocated slots.
+		 */
+		void make_empty()
+		{
+			std::fill(this->keys, this->keys + this->capacity, kEmptyKey);
+			this->reserved[0].reset();
+			this->reserved[1].reset();
+			this->current_size = 0;
+			this->deleted_size = 0;
+		}
+
+		/**
+		 * Insert the value under the key. If the key is already in the
+		 * integer_hash_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the integer_hash_table.
+		 */
+		bool insert(const T & value, const K key)
+		{
+			if (is_reserved(key))
+			{
+				auto & aside = this->reserved[reserved_index(key)];
+				const auto inserted = !aside.has_value();
+				aside = value;
+				this->current_size += inserted ? 1 : 0;
+				return inserted;
+			} // else, the key lives in the arrays, do_nothing();
+
+			if (this->capacity == 0)
+			{ // a moved from table allocates again.
+				this->rehash_to(kMinCapacity);
+			} // else, the arrays are allocated, do_nothing();
+			const auto mask = this->capacity - 1;
+			auto current_position = this->home(key);
+			auto free_position = this->capacity;
+			while (this->keys[current_position] != kEmptyKey)
+			{
+				if (this->keys[current_position] == key)
+				{
+					this->values[current_position] = value;
+					return false;
+				}
+				else if (this->keys[current_position] == kDeletedKey && free_position == this->capacity)
+				{ // the first tombstone is reused, when the key turns out to be missing.
+					free_position = current_position;
+				} // else, a different key, do_nothing();
+				current_position = (current_position + 1) & mask;
+			}
+
+			if (free_position != this->capacity)
+			{
+				--this->deleted_size;
+			}
+			else if (this->current_size + this->deleted_size + 1 > this->grow_threshold)
+			{ // grow unless the tombstones alone fill the table, then a rebuild of the same size drops them.
+				this->rehash_to(this->current_size + 1 > this->grow_threshold / 2 ? this->capacity * 2 : this->capacity);
+				free_position = this->free_position(key);
+			}
+			else
+			{
+				free_position = current_position;
+			}
+
+			this->keys[free_position] = key;
+			::new (static_cast<void *>(this->values + free_position)) T(value);
+			++this->current_size;
+			return true;
+		}
+
+		/**
+		 * Removes the entry stored under the key, leaving a tombstone in its slot.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the integer_hash_table.
+		 */
+		bool remove(const K key)
+		{
+			if (is_reserved(key))
+			{
+				auto & aside = this->reserved[reserved_index(key)];
+				if (!aside)
+				{
+					return false;
+				} // else, the entry is kept aside, do_nothing();
+				aside.reset();
+				--this->current_size;
+				return true;
+			} // else, the key lives in the arrays, do_nothing();
+
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				return false;
+			} // else, the key is in the table, do_nothing();
+
+			this->keys[current_position] = kDeletedKey;
+			--this->current_size;
+			++this->deleted_size;
+			return true;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the integer_hash_table throw a length error.
+		 */
+		T & get_key(const K key)
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the integer_hash_table throw a length error.
+		 */
+		const T & get_key(const K key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under the key, inserting a default value
+		 * when the key is missing.
+		 */
+		T & operator[](const K key)
+		{
+			auto found = this->find(key);
+			if (found != nullptr)
+			{
+				return *found;
+			} // else, the key is new, do_nothing();
+			this->insert(T{}, key);
+			return *this->find(key);
+		}
+
+		/**
+		 * The number of entries in the integer_hash_table.
+		 */
+		std::size_t size() const
+		{
+			return this->current_size;
+		}
+
+		/**
+		 * The fraction of slots that may hold entries or tombstones before the table grows. Defaults to 0.75.
+		 */
+		float max_load_factor() const
+		{
+			return this->load_limit;
+		}
+
+		/**
+		 * Set the fraction of slots that may hold entries or tombstones before the
+		 * table grows, growing right away if the table is already past it.
+		 * @param load the new max load factor, greater than zero and capped at 0.95.
+		 */
+		void max_load_factor(const float load)
+		{
+			if (!(load > 0.0f))
+			{
+				throw std::invalid_argument("Max load factor must be greater than zero....");
+			} // else, the load factor is valid, do_nothing();
+			this->load_limit = std::min(load, power_of_two_policy::max_load_factor());
+			this->grow_threshold = this->threshold_for(this->capacity);
+			if (this->current_size + this->deleted_size > this->grow_threshold)
+			{ // over the new limit, grow until the entries fit, the rebuild drops the tombstones.
+				auto new_capacity = this->capacity;
+				while (this->current_size > this->threshold_for(new_capacity))
+				{
+					new_capacity *= 2;
+				}
+				this->rehash_to(new_capacity);
+			} // else we are within the load factor do_nothing();
+		}
+
+		/**
+		 * Make room for the number of entries, so inserting them never grows the table.
+		 * @param count the number of entries to hold.
+		 */
+		void reserve(const std::size_t count)
+		{
+			auto new_capacity = std::max<std::size_t>(this->capacity, kMinCapacity);
+			while (count > this->threshold_for(new_capacity))
+			{
+				new_capacity *= 2;
+			}
+			if (new_capacity != this->capacity)
+			{
+				this->rehash_to(new_capacity);
+			} // else, there is already room, do_nothing();
+		}
+
+		/**
+		 * Call the function on every entry.
+		 * @param function called as function(const K & key, T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function)
+		{
+			this->visit(*this, function);
+		}
+
+		/**
+		 * Call the function on every entry.
+		 * @param function called as function(const K & key, const T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function) const
+		{
+			this->visit(*this, function);
+		}
+
+	private:
+		/**
+		 * The reserved key values marking a slot that never held an entry, and a
+		 * slot whose entry was removed.
+		 */
+		static constexpr K kEmptyKey = static_cast<K>(~std::uintmax_t{ 0 });
+		static constexpr K kDeletedKey = static_cast<K>(~std::uintmax_t{ 1 });
+
+		/**
+		 * The slots allocated by a table that was moved from, on its next insert.
+		 */
+		enum { kMinCapacity = 8 };
+
+		/**
+		 * The keys of the slots, kEmptyKey or kDeletedKey when free.
+		 */
+		K * keys{};
+
+		/**
+		 * The values of the slots, parallel to the keys, only set while the key is not reserved.
+		 */
+		T * values{};
+
+		/**
+		 * The number of slots, a power of two.
+		 */
+		std::size_t capacity{};
+
+		/**
+		 * The number of entries, those kept aside included.
+		 */
+		std::size_t current_size{};
+
+		/**
+		 * The number of slots holding kDeletedKey.
+		 */
+		std::size_t deleted_size{};
+
+		/**
+		 * The max load factor.
+		 */
+		float load_limit{ 0.75f };
+
+		/**
+		 * The number of entries and tombstones the slots may hold before growing.
+		 */
+		std::size_t grow_threshold{};
+
+		Hash hasher;
+
+		/**
+		 * The values of the entries under kEmptyKey and kDeletedKey, which can not be kept in the arrays.
+		 */
+		std::optional<T> reserved[2];
+
+		static bool is_reserved(const K key)
+		{
+			return key == kEmptyKey || key == kDeletedKey;
+		}
+
+		static std::size_t reserved_index(const K key)
+		{
+			return key == kEmptyKey ? 0 : 1;
+		}
+
+		/**
+		 * The number of entries a capacity holds under the max load factor, always leaving an empty slot.
+		 */
+		std::size_t threshold_for(const std::size_t size) const
+		{
+			return std::min(static_cast<std::size_t>(size * static_cast<double>(this->load_limit)), size - 1);
+		}
+
+		/**
+		 * The home bucket of the key.
+		 */
+		std::size_t home(const K key) const
+		{
+			return this->hasher(key) & (this->capacity - 1);
+		}
+
+		/**
+		 * Find the slot holding a key that is not reserved.
+		 * @param key the key being searched for.
+		 * @return the slot of the key, or the capacity when it is missing.
+		 */
+		std::size_t find_position(const K key) const
+		{
+			if (this->capacity == 0)
+			{ // a moved from table has no slots.
+				return this->capacity;
+			} // else, there are slots to probe, do_nothing();
+			const auto mask = this->capacity - 1;
+			auto current_position = this->home(key);
+			while (this->keys[current_position] != kEmptyKey)
+			{
+				if (this->keys[current_position] == key)
+				{
+					return current_position;
+				} // else, a different key or a tombstone, do_nothing();
+				current_position = (current_position + 1) & mask;
+			}
+			return this->capacity;
+		}
+
+		/**
+		 * Find the first empty slot of the probe sequence of a key, in an array without tombstones.
+		 */
+		std::size_t free_position(const K key) const
+		{
+			const auto mask = this->capacity - 1;
+			auto current_position = this->home(key);
+			while (this->keys[current_position] != kEmptyKey)
+			{
+				current_position = (current_position + 1) & mask;
+			}
+			return current_position;
+		}
+
+		/**
+		 * Rebuild the arrays with the given number of slots, copying every entry
+		 * and dropping the tombstones.
+		 */
+		void rehash_to(const std::size_t new_capacity)
+		{
+			auto old_keys = this->keys;
+			auto old_values = this->values;
+			const auto old_capacity = this->capacity;
+			this->allocate(new_capacity);
+
+			for (std::size_t i = 0; i < old_capacity; i++)
+			{
+				if (!is_reserved(old_keys[i]))
+				{
+					const auto current_position = this->free_position(old_keys[i]);
+					this->keys[current_position] = old_keys[i];
+					std::memcpy(static_cast<void *>(this->values + current_position), old_values + i, sizeof(T));
+				} // else, the slot holds no entry, do_nothing();
+			}
+			this->deleted_size = 0;
+			std::allocator<K>().deallocate(old_keys, old_capacity);
+			std::allocator<T>().deallocate(old_values, old_capacity);
+		}
+
+		/**
+		 * Allocate empty keys and raw values for the capacity.
+		 */
+		void allocate(const std::size_t new_capacity)
+		{
+			this->keys = std::allocator<K>().allocate(new_capacity);
+			std::fill(this->keys, this->keys + new_capacity, kEmptyKey);
+			this->values = std::allocator<T>().allocate(new_capacity);
+			this->capacity = new_capacity;
+			this->grow_threshold = this->threshold_for(new_capacity);
+		}
+
+		/**
+		 * Release the arrays, the values need no destruction.
+		 */
+		void deallocate()
+		{
+			if (this->keys != nullptr)
+			{
+				std::allocator<K>().deallocate(this->keys, this->capacity);
+				std::allocator<T>().deallocate(this->values, this->capacity);
+				this->keys = nullptr;
+				this->values = nullptr;
+			} // else, nothing was allocated, do_nothing();
+		}
+
+		/**
+		 * Call the function on every entry of the table, see for_each_active.
+		 */
+		template <typename Table, typename Function>
+		static void visit(Table & table, Function & function)
+		{
+			for (std::size_t i = 0; i < table.capacity; i++)
+			{
+				if (!is_reserved(table.keys[i]))
+				{
+					function(static_cast<const K &>(table.keys[i]), table.values[i]);
+				} // else, the slot holds no entry, do_nothing();
+			}
+			if (table.reserved[0])
+			{
+				function(kEmptyKey, *table.reserved[0]);
+			} // else, there is no entry under kEmptyKey, do_nothing();
+			if (table.reserved[1])
+			{
+				function(kDeletedKey, *table.reserved[1]);
+			} // else, there is no entry under kDeletedKey, do_nothing();
+		}
+	};
+}
+
+#endif
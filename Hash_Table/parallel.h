@@ -0,0 +1,102 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace nwacc {
+
+	/**
+	 * Split [0, count) into contiguous pieces and call function(begin, end) on
+	 * each piece from its own std::thread, the calling thread taking the first
+	 * piece. Small counts run inline. The first exception thrown by a piece is
+	 * rethrown once every thread has been joined.
+	 * @param count the number of items.
+	 * @param function called as function(begin, end) for each piece.
+	 * @param threads the number of threads to use, zero for one per hardware thread.
+	 * @param min_piece the fewest items worth handing to a thread.
+	 */
+	template <typename Function>
+	void parallel_for(const std::size_t count, Function && function, unsigned threads = 0,
+		const std::size_t min_piece = std::size_t{ 1 } << 14)
+	{
+		if (threads == 0)
+		{
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		} // else, the caller picked the number of threads, do_nothing();
+
+		const auto pieces = std::min<std::size_t>(threads, (count + min_piece - 1) / std::max<std::size_t>(min_piece, 1));
+		if (pieces <= 1)
+		{
+			function(std::size_t{ 0 }, count);
+			return;
+		} // else, the work is worth splitting, do_nothing();
+
+		std::vector<std::exception_ptr> errors(pieces);
+		std::vector<std::thread> workers;
+		workers.reserve(pieces - 1);
+		const auto run = [&](const std::size_t piece)
+		{
+			try
+			{
+				function(count * piece / pieces, count * (piece + 1) / pieces);
+			}
+			catch (...)
+			{
+				errors[piece] = std::current_exception();
+			}
+		};
+
+		for (std::size_t piece = 1; piece < pieces; piece++)
+		{
+			workers.emplace_back(run, piece);
+		}
+		run(0);
+		for (auto & worker : workers)
+		{
+			worker.join();
+		}
+
+		for (const auto & error : errors)
+		{
+			if (error)
+			{
+				std::rethrow_exception(error);
+			} // else, the piece finished fine, do_nothing();
+		}
+	}
+
+	/**
+	 * The default executor of the parallel algorithms of the tables, such as
+	 * hash_table::parallel_rehash. An executor is called as executor(count, task)
+	 * and must call task(i) once for every i in [0, count), on any threads and in
+	 * any order, returning once every call is done. A thread pool fits by
+	 * submitting the tasks and waiting on them, std::execution::par by running
+	 * std::for_each over the indexes. This one runs the tasks on std::threads
+	 * through parallel_for.
+	 */
+	struct thread_executor
+	{
+		/**
+		 * The number of threads to use, zero for one per hardware thread.
+		 */
+		unsigned threads{};
+
+		template <typename Task>
+		void operator()(const std::size_t count, Task && task) const
+		{
+			parallel_for(count, [&](const std::size_t begin, const std::size_t end)
+			{
+				for (auto i = begin; i < end; i++)
+				{
+					task(i);
+				}
+			}, this->threads, 1);
+		}
+	};
+}
+
+#endif
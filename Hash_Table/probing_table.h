@@ -0,0 +1,48 @@
+#ifndef PROBING_TABLE_H_
+#define PROBING_TABLE_H_
+
+#include <functional>
+#include <type_traits>
+
+#include "hash_table.h"
+#include "integer_hash_table.h"
+#include "robin_hood_table.h"
+#include "swiss_table.h"
+
+namespace nwacc {
+
+	/**
+	 * The open addressing backends sharing the key side of the hash_table interface.
+	 * quadratic is the hash_table itself, swiss is the swiss_table with its control
+	 * byte groups, and robin_hood is the robin_hood_table with backward shift deletion.
+	 */
+	enum class probing { quadratic, swiss, robin_hood };
+
+	/**
+	 * Pick a backend at compile time, so the probing scheme of a table can be
+	 * changed in one place without touching the code that uses it.
+	 * For example probing_table<probing::robin_hood, std::string, int>.
+	 */
+	template <probing Probing, typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>>
+	using probing_table = typename std::conditional<Probing == probing::robin_hood,
+		robin_hood_table<T, K, Hash, KeyEqual>,
+		typename std::conditional<Probing == probing::swiss,
+			swiss_table<T, K, Hash, KeyEqual>,
+			hash_table<T, K, Hash, KeyEqual>>::type>::type;
+
+	/**
+	 * Pick the most compact table for the entry at compile time. An integer key
+	 * with a trivially copyable value goes to the integer_hash_table, with its
+	 * flat key and value arrays and reserved key values, every other entry to
+	 * the hash_table. For example compact_hash_table<std::uint32_t, std::uint64_t>
+	 * takes 12 bytes a slot instead of the 17 of a hash_table.
+	 */
+	template <typename T, typename K>
+	using compact_hash_table = typename std::conditional<is_compact_entry<T, K>::value,
+		integer_hash_table<T, K>,
+		hash_table<T, K>>::type;
+}
+
+#endif
@@ -0,0 +1,688 @@
+#ifndef ROBIN_HOOD_TABLE_H_
+#define ROBIN_HOOD_TABLE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "hash_policy.h"
+
+namespace nwacc {
+
+	/**
+	 * Open addressing hash table of values T stored under keys K that uses
+	 * Robin Hood linear probing. Every slot records how far its entry sits from
+	 * its home bucket, and an insert takes the slot of any entry that is closer
+	 * to home than the one being placed. This keeps the probe lengths of all
+	 * entries close together, so the worst case lookup stays short even at high
+	 * load factors, and a miss ends as soon as it reaches an entry closer to
+	 * home than itself. Removal shifts the following entries back one slot
+	 * instead of leaving a tombstone.
+	 * Offers the key side of the hash_table interface.
+	 * @tparam Hash the function object hashing a key.
+	 * @tparam KeyEqual the function object comparing two keys for equality.
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>>
+	class robin_hood_table
+	{
+	public:
+		/**
+		 * Create a new robin_hood_table with at least the given number of slots.
+		 * @param size the number of slots to allocate.
+		 * @param hash the function object hashing a key.
+		 * @param equal the function object comparing two keys.
+		 */
+		explicit robin_hood_table(std::size_t size = 8,
+			const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual())
+			: hasher(hash), key_equal(equal)
+		{
+			this->allocate(power_of_two_policy::next_size(size));
+		}
+
+		robin_hood_table(const robin_hood_table & rhs)
+			: load_limit(rhs.load_limit), hasher(rhs.hasher), key_equal(rhs.key_equal)
+		{
+			this->allocate(rhs.capacity);
+			for (std::size_t i = 0; i < rhs.capacity; i++)
+			{
+				if (rhs.distance[i] != kEmpty)
+				{
+					this->place(entry(rhs.slots[i].element, rhs.slots[i].key));
+				} // else, the slot holds no entry, do_nothing();
+			}
+			this->current_size = rhs.current_size;
+		}
+
+		/**
+		 * Move the entries of another robin_hood_table, which is left with no
+		 * slots and allocates again on its next insert.
+		 */
+		robin_hood_table(robin_hood_table && rhs) noexcept
+			: distance(std::move(rhs.distance)), slots(rhs.slots), capacity(rhs.capacity),
+			current_size(rhs.current_size), load_limit(rhs.load_limit), grow_threshold(rhs.grow_threshold),
+			distance_bound(rhs.distance_bound), hasher(std::move(rhs.hasher)), key_equal(std::move(rhs.key_equal))
+		{
+			rhs.slots = nullptr;
+			rhs.capacity = 0;
+			rhs.current_size = 0;
+			rhs.grow_threshold = 0;
+			rhs.distance_bound = kEmpty;
+		}
+
+		robin_hood_table & operator=(robin_hood_table rhs) noexcept
+		{
+			this->swap(rhs);
+			return *this;
+		}
+
+		~robin_hood_table()
+		{
+			this->destroy_entries();
+			this->deallocate();
+		}
+
+		/**
+		 * Exchange the contents of two robin_hood_tables.
+		 */
+		void swap(robin_hood_table & rhs) noexcept
+		{
+			using std::swap;
+			swap(this->distance, rhs.distance);
+			swap(this->slots, rhs.slots);
+			swap(this->capacity, rhs.capacity);
+			swap(this->current_size, rhs.current_size);
+			swap(this->load_limit, rhs.load_limit);
+			swap(this->grow_threshold, rhs.grow_threshold);
+			swap(this->distance_bound, rhs.distance_bound);
+			swap(this->hasher, rhs.hasher);
+			swap(this->key_equal, rhs.key_equal);
+		}
+
+		/**
+		 * Determine if the robin_hood_table contains an entry with a matching key.
+		 */
+		bool contains(const K & key) const
+		{
+			return this->find_position(key) != this->capacity;
+		}
+
+		/**
+		 * Determine if the robin_hood_table contains an entry with a key equal to a value
+		 * of another type, without building a temporary key. Needs a transparent
+		 * Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		bool contains(const Q & key) const
+		{
+			return this->find_position(key) != this->capacity;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const K & key)
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const K & key) const
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Find the value stored under a key equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		T * find(const Q & key)
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Find the value stored under a key equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		const T * find(const Q & key) const
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Remove every entry, keeping the allocated slots.
+		 */
+		void make_empty()
+		{
+			this->destroy_entries();
+			std::fill(this->distance.begin(), this->distance.end(), kEmpty);
+			this->distance_bound = kEmpty;
+			this->current_size = 0;
+		}
+
+		/**
+		 * Insert the value under the key. If the key is already in the
+		 * robin_hood_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the robin_hood_table.
+		 * @throws std::length_error if too many keys share a home bucket, the table is left unchanged.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			return this->insert_entry(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics. If the key is
+		 * already in the robin_hood_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the robin_hood_table.
+		 * @throws std::length_error if too many keys share a home bucket, the table is left unchanged.
+		 */
+		bool insert(T && value, K && key)
+		{
+			return this->insert_entry(std::move(value), std::move(key));
+		}
+
+		/**
+		 * Removes the entry stored under the key, shifting the entries after it
+		 * back towards their home buckets.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the robin_hood_table.
+		 */
+		bool remove(const K & key)
+		{
+			return this->remove_key(key);
+		}
+
+		/**
+		 * Removes the entry whose key is equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 * @param key the value compared against the keys.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the robin_hood_table.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		bool remove(const Q & key)
+		{
+			return this->remove_key(key);
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the robin_hood_table throw a length error.
+		 */
+		T & get_key(const K & key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the robin_hood_table throw a length error.
+		 */
+		const T & get_key(const K & key) const
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under a key equal to a value of another type.
+		 * If the key does not exist in the robin_hood_table throw a length error.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		T & get_key(const Q & key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under a key equal to a value of another type.
+		 * If the key does not exist in the robin_hood_table throw a length error.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		const T & get_key(const Q & key) const
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under the key, inserting a default value
+		 * when the key is missing.
+		 */
+		T & operator[](const K & key)
+		{
+			if (!this->contains(key))
+			{
+				this->insert_entry(T{}, key);
+			} // else, the key is already in the robin_hood_table, do_nothing();
+			return this->slots[this->find_position(key)].element;
+		}
+
+		/**
+		 * The number of entries in the robin_hood_table.
+		 */
+		std::size_t size() const
+		{
+			return this->current_size;
+		}
+
+		/**
+		 * The fraction of slots that may hold entries before the table grows. Defaults to 0.875.
+		 */
+		float max_load_factor() const
+		{
+			return this->load_limit;
+		}
+
+		/**
+		 * Set the fraction of slots that may hold entries before the table grows,
+		 * growing right away if the table is already past it.
+		 * @param load the new max load factor, greater than zero and capped at 0.95.
+		 */
+		void max_load_factor(const float load)
+		{
+			if (!(load > 0.0f))
+			{
+				throw std::invalid_argument("Max load factor must be greater than zero....");
+			} // else, the load factor is valid, do_nothing();
+			this->load_limit = std::min(load, power_of_two_policy::max_load_factor());
+			this->grow_threshold = this->threshold_for(this->capacity);
+			while (this->current_size > this->grow_threshold)
+			{
+				this->rehash_to(this->capacity * 2);
+			}
+		}
+
+		/**
+		 * The longest distance of any entry from its home bucket, the number of
+		 * extra slots the worst successful lookup has to check.
+		 */
+		std::size_t max_probe_length() const
+		{
+			std::size_t longest = 0;
+			for (const auto current_distance : this->distance)
+			{
+				if (current_distance != kEmpty)
+				{
+					longest = std::max<std::size_t>(longest, current_distance - 1);
+				} // else, the slot holds no entry, do_nothing();
+			}
+			return longest;
+		}
+
+	private:
+		/**
+		 * The storage of one slot, only constructed while its distance is not kEmpty.
+		 */
+		struct entry
+		{
+			T element;
+			K key;
+
+			template <typename V, typename Q>
+			entry(V && e, Q && k) : element(std::forward<V>(e)), key(std::forward<Q>(k)) { }
+		};
+
+		/**
+		 * A slot with a distance of kEmpty holds no entry, otherwise the distance
+		 * is one more than the number of slots its entry sits past its home bucket.
+		 * kMaxDistance is the largest distance that fits in a slot, an insert that
+		 * would go further grows the table instead.
+		 */
+		enum slot_distance : std::uint8_t { kEmpty = 0, kMaxDistance = 0xFF };
+
+		/**
+		 * The slots allocated by a table that was moved from, on its next insert.
+		 */
+		enum { kMinCapacity = 8 };
+
+		/**
+		 * An insert only grows the table for a crowded bucket while at least one
+		 * slot in kSparseRatio holds an entry. Past that more slots do not spread
+		 * the keys, they share a home under any size, about four doublings after
+		 * the load limit.
+		 */
+		enum { kSparseRatio = 16 };
+
+		/**
+		 * The distance of every slot, parallel to the entry storage.
+		 */
+		std::vector<std::uint8_t> distance;
+
+		/**
+		 * Raw storage for the entries.
+		 */
+		entry * slots{};
+
+		/**
+		 * The number of slots, a power of two.
+		 */
+		std::size_t capacity{};
+
+		/**
+		 * The number of entries.
+		 */
+		std::size_t current_size{};
+
+		/**
+		 * The max load factor.
+		 */
+		float load_limit{ 0.875f };
+
+		/**
+		 * The number of entries the slots may hold before growing.
+		 */
+		std::size_t grow_threshold{};
+
+		/**
+		 * At least the largest distance of any slot. Raised by place and reset by a
+		 * rebuild, an erase may leave it above the true largest distance.
+		 */
+		std::uint8_t distance_bound{ kEmpty };
+
+		Hash hasher;
+
+		KeyEqual key_equal;
+
+		/**
+		 * The number of entries a capacity holds under the max load factor, always leaving an empty slot.
+		 */
+		std::size_t threshold_for(const std::size_t size) const
+		{
+			return std::min(static_cast<std::size_t>(size * static_cast<double>(this->load_limit)), size - 1);
+		}
+
+		/**
+		 * The home bucket of the key.
+		 */
+		template <typename Q>
+		std::size_t home(const Q & key) const
+		{
+			return power_of_two_policy::index(this->hasher(key), this->capacity);
+		}
+
+		/**
+		 * Find the slot holding the key. The probe stops at the first slot whose
+		 * entry is closer to its home than the key would be, because the insert
+		 * of the key would have taken that slot.
+		 * @param key the key being searched for.
+		 * @return the slot of the key, or the capacity when it is missing.
+		 */
+		template <typename Q>
+		std::size_t find_position(const Q & key) const
+		{
+			if (this->capacity == 0)
+			{ // a moved from table has no slots.
+				return this->capacity;
+			} // else, there are slots to probe, do_nothing();
+			const auto mask = this->capacity - 1;
+			auto current_position = this->home(key);
+			std::size_t wanted = 1;
+
+			while (this->distance[current_position] >= wanted)
+			{
+				if (this->distance[current_position] == wanted &&
+					this->key_equal(this->slots[current_position].key, key))
+				{ // only an entry as far from home as the key can share its home bucket.
+					return current_position;
+				} // else, a different key, do_nothing();
+				current_position = (current_position + 1) & mask;
+				++wanted;
+			}
+			return this->capacity;
+		}
+
+		/**
+		 * The value stored under the key, or nullptr when it is missing.
+		 */
+		template <typename Q>
+		T * find_element(const Q & key) const
+		{
+			const auto current_position = this->find_position(key);
+			return current_position == this->capacity ? nullptr : &this->slots[current_position].element;
+		}
+
+		/**
+		 * Remove the entry stored under the key.
+		 * @param key the key, or a value comparable with the keys.
+		 * @return true if an entry was removed.
+		 */
+		template <typename Q>
+		bool remove_key(const Q & key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				return false;
+			}
+			else
+			{
+				this->erase_at(current_position);
+				return true;
+			}
+		}
+
+		/**
+		 * Insert or replace the entry of the key.
+		 */
+		template <typename V, typename Q>
+		bool insert_entry(V && value, Q && key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position != this->capacity)
+			{
+				this->slots[current_position].element = std::forward<V>(value);
+				return false;
+			} // else, the key is new, do_nothing();
+
+			if (this->current_size + 1 > this->grow_threshold)
+			{ // a moved from table has no slots, it starts again from the smallest size.
+				this->rehash_to(this->capacity == 0 ? static_cast<std::size_t>(kMinCapacity) : this->capacity * 2);
+			} // else we are within the load factor do_nothing();
+			while (this->distance_bound + 1 >= kMaxDistance && this->would_overflow(key))
+			{ // the distances are near the limit, grow before any entry moves, or give up while nothing has.
+				if (this->capacity / kSparseRatio > this->current_size)
+				{
+					throw std::length_error("Too many keys share a home bucket of the robin_hood_table....");
+				} // else, more slots may still spread the keys, do_nothing();
+				this->rehash_to(this->capacity * 2);
+			}
+			this->place(entry(std::forward<V>(value), std::forward<Q>(key)));
+			++this->current_size;
+			return true;
+		}
+
+		/**
+		 * Robin Hood insert of an entry whose key is known to be missing. The
+		 * entry being carried swaps places with any entry closer to its home,
+		 * and the displaced entry is carried on until an empty slot is found.
+		 * Does not count the entry.
+		 * @param carried the entry being placed.
+		 */
+		void place(entry && carried)
+		{
+			const auto mask = this->capacity - 1;
+			auto current_position = this->home(carried.key);
+			std::uint8_t carried_distance = 1;
+
+			while (this->distance[current_position] != kEmpty)
+			{
+				if (this->distance[current_position] < carried_distance)
+				{ // the resident is closer to home, it gives up its slot.
+					using std::swap;
+					swap(this->slots[current_position], carried);
+					swap(this->distance[current_position], carried_distance);
+					this->distance_bound = std::max(this->distance_bound, this->distance[current_position]);
+				} // else, the resident stays, do_nothing();
+
+				current_position = (current_position + 1) & mask;
+				if (carried_distance == kMaxDistance)
+				{ // the probe would no longer fit in a slot, grow and start over.
+					this->rehash_to(this->capacity * 2);
+					this->place(std::move(carried));
+					return;
+				} // else, keep walking, do_nothing();
+				++carried_distance;
+			}
+
+			::new (static_cast<void *>(this->slots + current_position)) entry(std::move(carried));
+			this->distance[current_position] = carried_distance;
+			this->distance_bound = std::max(this->distance_bound, carried_distance);
+		}
+
+		/**
+		 * Determine if placing a missing key could take a distance past kMaxDistance.
+		 * The key walks on while the residents are as far from home as it would be.
+		 * After that every resident up to the next empty slot may move one slot on.
+		 * @param key the key about to be placed.
+		 * @return true if the key or a resident it displaces would need a distance past kMaxDistance.
+		 */
+		template <typename Q>
+		bool would_overflow(const Q & key) const
+		{
+			const auto mask = this->capacity - 1;
+			auto current_position = this->home(key);
+			std::size_t wanted = 1;
+			while (this->distance[current_position] >= wanted)
+			{
+				current_position = (current_position + 1) & mask;
+				if (++wanted == kMaxDistance)
+				{
+					return true;
+				} // else, keep walking, do_nothing();
+			}
+			for (; this->distance[current_position] != kEmpty; current_position = (current_position + 1) & mask)
+			{
+				if (this->distance[current_position] + 1 >= kMaxDistance)
+				{
+					return true;
+				} // else, the resident can move one slot on, do_nothing();
+			}
+			return false;
+		}
+
+		/**
+		 * Destroy the entry of a slot and shift the following entries back
+		 * until one is at its home bucket or a slot is empty.
+		 */
+		void erase_at(std::size_t current_position)
+		{
+			const auto mask = this->capacity - 1;
+			auto next_position = (current_position + 1) & mask;
+			while (this->distance[next_position] > 1)
+			{
+				this->slots[current_position] = std::move(this->slots[next_position]);
+				this->distance[current_position] = static_cast<std::uint8_t>(this->distance[next_position] - 1);
+				current_position = next_position;
+				next_position = (next_position + 1) & mask;
+			}
+
+			this->slots[current_position].~entry();
+			this->distance[current_position] = kEmpty;
+			--this->current_size;
+		}
+
+		/**
+		 * Rebuild the table with the given number of slots, moving every entry.
+		 */
+		void rehash_to(const std::size_t new_capacity)
+		{
+			auto old_distance = std::move(this->distance);
+			auto old_slots = this->slots;
+			const auto old_capacity = this->capacity;
+			this->allocate(new_capacity);
+
+			for (std::size_t i = 0; i < old_capacity; i++)
+			{
+				if (old_distance[i] != kEmpty)
+				{
+					this->place(std::move(old_slots[i]));
+					old_slots[i].~entry();
+				} // else, the slot holds no entry, do_nothing();
+			}
+			std::allocator<entry>().deallocate(old_slots, old_capacity);
+		}
+
+		/**
+		 * Allocate empty distances and raw slots for the capacity.
+		 */
+		void allocate(const std::size_t new_capacity)
+		{
+			this->distance.assign(new_capacity, kEmpty);
+			this->distance_bound = kEmpty;
+			this->slots = std::allocator<entry>().allocate(new_capacity);
+			this->capacity = new_capacity;
+			this->grow_threshold = this->threshold_for(new_capacity);
+		}
+
+		/**
+		 * Release the raw slots, the entries must already be destroyed.
+		 */
+		void deallocate()
+		{
+			if (this->slots != nullptr)
+			{
+				std::allocator<entry>().deallocate(this->slots, this->capacity);
+				this->slots = nullptr;
+			} // else, nothing was allocated, do_nothing();
+		}
+
+		/**
+		 * Destroy every entry.
+		 */
+		void destroy_entries()
+		{
+			for (std::size_t i = 0; i < this->capacity; i++)
+			{
+				if (this->distance[i] != kEmpty)
+				{
+					this->slots[i].~entry();
+				} // else, the slot holds no entry, do_nothing();
+			}
+		}
+	};
+}
+
+#endif
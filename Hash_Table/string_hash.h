@@ -0,0 +1,39 @@
+#ifndef STRING_HASH_H_
+#define STRING_HASH_H_
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+namespace nwacc {
+
+	/**
+	 * Transparent hash for std::string keys. Hashes std::string, std::string_view,
+	 * and const char * alike, so a table using it can look up a key from a view
+	 * into a buffer without building a temporary std::string.
+	 */
+	struct string_hash
+	{
+		typedef void is_transparent;
+
+		std::size_t operator()(const std::string_view value) const
+		{
+			return std::hash<std::string_view>()(value);
+		}
+	};
+
+	/**
+	 * Transparent equality to go with string_hash.
+	 */
+	struct string_equal
+	{
+		typedef void is_transparent;
+
+		bool operator()(const std::string_view lhs, const std::string_view rhs) const
+		{
+			return lhs == rhs;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,709 @@
+#ifndef STRING_INTERN_TABLE_H_
+#define STRING_INTERN_TABLE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hash_policy.h"
+#include "string_hash.h"
+
+namespace nwacc {
+
+	/**
+	 * Open addressing hash table of values T stored under string keys, built for
+	 * symbol tables holding very many short strings. No key is a std::string:
+	 * the bytes of every key longer than 7 characters are appended to one
+	 * contiguous arena, and its slot keeps a 32 bit offset and length into it,
+	 * while a key of up to 7 characters is kept whole in its slot. A slot is
+	 * 12 bytes, a 32 bit tag of the hash code and 8 bytes of key, so there is
+	 * no allocation per key and a probe compares the tag before any key byte.
+	 * The values are kept in their own array, parallel to the slots.
+	 * A removed key leaves its bytes in the arena, the arena is packed again
+	 * by the next insert or rebuild of the slots once most of it is dead.
+	 * Linear probing on a power of two size, with tombstones.
+	 * Offers the key side of the hash_table interface, with std::string_view keys.
+	 * @tparam Hash the function object hashing a std::string_view.
+	 */
+	template <typename T, typename Hash = string_hash>
+	class string_intern_table
+	{
+	public:
+		/**
+		 * Create a new string_intern_table with at least the given number of slots.
+		 * @param size the number of slots to allocate.
+		 * @param hash the function object hashing a key.
+		 */
+		explicit string_intern_table(std::size_t size = 8, const Hash & hash = Hash())
+			: hasher(hash)
+		{
+			this->allocate(power_of_two_policy::next_size(size));
+		}
+
+		string_intern_table(const string_intern_table & rhs)
+			: arena(rhs.arena), current_size(rhs.current_size), deleted_size(rhs.deleted_size),
+			dead_bytes(rhs.dead_bytes), hasher(rhs.hasher)
+		{
+			this->allocate(rhs.capacity);
+			std::copy(rhs.slots, rhs.slots + rhs.capacity, this->slots);
+			for (std::size_t i = 0; i < this->capacity; i++)
+			{
+				if (is_active(this->slots[i]))
+				{
+					try
+					{
+						::new (static_cast<void *>(this->values + i)) T(rhs.values[i]);
+					}
+					catch (...)
+					{ // give up the copies built so far, the slots after i hold no value yet.
+						for (std::size_t j = i; j < this->capacity; j++)
+						{
+							this->slots[j].tag = kEmptyTag;
+						}
+						this->destroy_values();
+						this->deallocate();
+						throw;
+					}
+				} // else, the slot holds no value, do_nothing();
+			}
+		}
+
+		/**
+		 * Move the entries of another string_intern_table, which is left with no
+		 * slots and allocates again on its next insert or reserve.
+		 */
+		string_intern_table(string_intern_table && rhs) noexcept
+			: arena(std::move(rhs.arena)), slots(rhs.slots), values(rhs.values), capacity(rhs.capacity),
+			current_size(rhs.current_size), deleted_size(rhs.deleted_size), dead_bytes(rhs.dead_bytes),
+			grow_threshold(rhs.grow_threshold), hasher(std::move(rhs.hasher))
+		{
+			rhs.slots = nullptr;
+			rhs.values = nullptr;
+			rhs.capacity = 0;
+			rhs.current_size = 0;
+			rhs.deleted_size = 0;
+			rhs.dead_bytes = 0;
+			rhs.grow_threshold = 0;
+		}
+
+		string_intern_table & operator=(string_intern_table rhs) noexcept
+		{
+			this->swap(rhs);
+			return *this;
+		}
+
+		~string_intern_table()
+		{
+			this->destroy_values();
+			this->deallocate();
+		}
+
+		/**
+		 * Exchange the contents of two string_intern_tables.
+		 */
+		void swap(string_intern_table & rhs) noexcept
+		{
+			using std::swap;
+			swap(this->arena, rhs.arena);
+			swap(this->slots, rhs.slots);
+			swap(this->values, rhs.values);
+			swap(this->capacity, rhs.capacity);
+			swap(this->current_size, rhs.current_size);
+			swap(this->deleted_size, rhs.deleted_size);
+			swap(this->dead_bytes, rhs.dead_bytes);
+			swap(this->grow_threshold, rhs.grow_threshold);
+			swap(this->hasher, rhs.hasher);
+		}
+
+		/**
+		 * Determine if the string_intern_table contains an entry with a matching key.
+		 */
+		bool contains(const std::string_view key) const
+		{
+			return this->find_position(probe_key(key, this->hasher(key))) != this->capacity;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const std::string_view key)
+		{
+			const auto current_position = this->find_position(probe_key(key, this->hasher(key)));
+			return current_position == this->capacity ? nullptr : this->values + current_position;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const std::string_view key) const
+		{
+			return const_cast<string_intern_table *>(this)->find(key);
+		}
+
+		/**
+		 * Insert the value under the key. If the key is already in the
+		 * string_intern_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted, its bytes are copied.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the string_intern_table.
+		 * @throws std::length_error if the key or the arena outgrows a 32 bit offset.
+		 */
+		bool insert(const T & value, const std::string_view key)
+		{
+			return this->insert_entry(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics, see insert.
+		 */
+		bool insert(T && value, const std::string_view key)
+		{
+			return this->insert_entry(std::move(value), key);
+		}
+
+		/**
+		 * Removes the entry stored under the key, leaving a tombstone in its slot.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the string_intern_table.
+		 */
+		bool remove(const std::string_view key)
+		{
+			const auto current_position = this->find_position(probe_key(key, this->hasher(key)));
+			if (current_position == this->capacity)
+			{
+				return false;
+			} // else, the key is in the table, do_nothing();
+
+			if (!is_inline(this->slots[current_position]))
+			{
+				this->dead_bytes += key.size();
+			} // else, the key took no arena bytes, do_nothing();
+			this->values[current_position].~T();
+			this->slots[current_position].tag = kDeletedTag;
+			--this->current_size;
+			++this->deleted_size;
+			return true;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the string_intern_table throw a length error.
+		 */
+		T & get_key(const std::string_view key)
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the string_intern_table throw a length error.
+		 */
+		const T & get_key(const std::string_view key) const
+		{
+			auto found = this->find(key);
+			if (found == nullptr)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return *found;
+		}
+
+		/**
+		 * Returns the value stored under the key, inserting a default value
+		 * when the key is missing.
+		 */
+		T & operator[](const std::string_view key)
+		{
+			auto found = this->find(key);
+			if (found != nullptr)
+			{
+				return *found;
+			} // else, the key is new, do_nothing();
+			this->insert_entry(T(), key);
+			return *this->find(key);
+		}
+
+		/**
+		 * Remove every entry and every key byte, keeping the allocated slots.
+		 */
+		void make_empty()
+		{
+			this->destroy_values();
+			for (std::size_t i = 0; i < this->capacity; i++)
+			{
+				this->slots[i].tag = kEmptyTag;
+			}
+			this->arena.clear();
+			this->current_size = 0;
+			this->deleted_size = 0;
+			this->dead_bytes = 0;
+		}
+
+		/**
+		 * Make room for the number of entries and key bytes, so inserting them never grows the table.
+		 * @param count the number of entries to hold.
+		 * @param key_bytes the number of bytes of the keys longer than 7 characters.
+		 */
+		void reserve(const std::size_t count, const std::size_t key_bytes = 0)
+		{
+			this->arena.reserve(key_bytes);
+			auto new_capacity = std::max<std::size_t>(this->capacity, kMinCapacity);
+			while (count > threshold_for(new_capacity))
+			{
+				new_capacity *= 2;
+			}
+			if (new_capacity != this->capacity)
+			{
+				this->rehash_to(new_capacity);
+			} // else, there is already room, do_nothing();
+		}
+
+		/**
+		 * The number of entries in the string_intern_table.
+		 */
+		std::size_t size() const
+		{
+			return this->current_size;
+		}
+
+		/**
+		 * The number of bytes in the key arena, those of removed keys included.
+		 */
+		std::size_t arena_size() const
+		{
+			return this->arena.size();
+		}
+
+		/**
+		 * Call the function on every entry. The key views stay valid until the
+		 * next insert, rehash, or make_empty.
+		 * @param function called as function(std::string_view key, T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function)
+		{
+			this->visit(*this, function);
+		}
+
+		/**
+		 * Call the function on every entry, see for_each_active.
+		 * @param function called as function(std::string_view key, const T & value).
+		 */
+		template <typename Function>
+		void for_each_active(Function function) const
+		{
+			this->visit(*this, function);
+		}
+
+	private:
+		/**
+		 * The longest key kept whole in its slot.
+		 */
+		enum { kInlineLength = 7 };
+
+		/**
+		 * The slots allocated by a table that was moved from, on its next insert.
+		 */
+		enum { kMinCapacity = 8 };
+
+		/**
+		 * The tags of a slot that never held an entry, and of one whose entry was
+		 * removed. An entry whose hash gives either gets kFirstTag instead.
+		 */
+		enum : std::uint32_t { kEmptyTag = 0, kDeletedTag = 1, kFirstTag = 2 };
+
+		/**
+		 * Set in the last key byte of a slot holding its key inline, whose low bits are then the length.
+		 */
+		enum : unsigned char { kInlineFlag = 0x80 };
+
+		/**
+		 * The highest fraction of slots holding entries or tombstones.
+		 */
+		static constexpr double kMaxLoad = 0.8;
+
+		/**
+		 * One slot. A key of up to 7 characters is kept in key[0] to key[6], with
+		 * kInlineFlag and the length in key[7]. A longer key keeps its arena offset
+		 * in key[0] to key[3] and its length in key[4] to key[7], both little
+		 * endian, the length below 2^31 so kInlineFlag stays clear.
+		 */
+		struct slot
+		{
+			std::uint32_t tag;
+			unsigned char key[8];
+		};
+
+		static_assert(sizeof(slot) == 12, "a string_intern_table slot is 12 bytes");
+
+		/**
+		 * A key being searched for, with its tag, home, and inline form worked out once.
+		 */
+		struct probe_key
+		{
+			std::string_view text;
+			std::size_t code;
+			std::uint32_t tag;
+			unsigned char key[8]{};
+
+			probe_key(const std::string_view key, const std::size_t hash)
+				: text(key), code(mix(hash))
+			{
+				const auto high = static_cast<std::uint32_t>(static_cast<std::uint64_t>(this->code) >> 32);
+				const auto low = static_cast<std::uint32_t>(this->code);
+				this->tag = std::max<std::uint32_t>(high ^ low, kFirstTag);
+				if (key.size() <= kInlineLength)
+				{
+					std::memcpy(this->key, key.data(), key.size());
+					this->key[7] = static_cast<unsigned char>(kInlineFlag | key.size());
+				} // else, the key lives in the arena, do_nothing();
+			}
+		};
+
+		std::vector<char> arena;
+
+		slot * slots{};
+
+		/**
+		 * Raw storage for the values, parallel to the slots, only constructed while active.
+		 */
+		T * values{};
+
+		/**
+		 * The number of slots, a power of two.
+		 */
+		std::size_t capacity{};
+
+		std::size_t current_size{};
+
+		std::size_t deleted_size{};
+
+		/**
+		 * The number of arena bytes of removed keys.
+		 */
+		std::size_t dead_bytes{};
+
+		/**
+		 * The number of entries and tombstones the slots may hold before growing.
+		 */
+		std::size_t grow_threshold{};
+
+		Hash hasher;
+
+		static bool is_active(const slot & current)
+		{
+			return current.tag >= kFirstTag;
+		}
+
+		static bool is_inline(const slot & current)
+		{
+			return (current.key[7] & kInlineFlag) != 0;
+		}
+
+		static void store32(unsigned char * bytes, const std::uint32_t word)
+		{
+			bytes[0] = static_cast<unsigned char>(word);
+			bytes[1] = static_cast<unsigned char>(word >> 8);
+			bytes[2] = static_cast<unsigned char>(word >> 16);
+			bytes[3] = static_cast<unsigned char>(word >> 24);
+		}
+
+		static std::uint32_t load32(const unsigned char * bytes)
+		{
+			return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+				static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+		}
+
+		/**
+		 * The key of an active slot, viewing the slot itself or the arena.
+		 */
+		std::string_view key_of(const slot & current) const
+		{
+			if (is_inline(current))
+			{
+				return std::string_view(reinterpret_cast<const char *>(current.key), current.key[7] & kInlineLength);
+			} // else, the key lives in the arena, do_nothing();
+			return std::string_view(this->arena.data() + load32(current.key), load32(current.key + 4));
+		}
+
+		/**
+		 * Determine if an active slot with a matching tag holds the key.
+		 */
+		bool holds(const slot & current, const probe_key & key) const
+		{
+			if (key.text.size() <= kInlineLength)
+			{ // the flag byte holds the length, so equal bytes mean an equal key.
+				return std::memcmp(current.key, key.key, sizeof(current.key)) == 0;
+			} // else, only an arena key of the same length can match, do_nothing();
+			return !is_inline(current) && load32(current.key + 4) == key.text.size() &&
+				std::memcmp(this->arena.data() + load32(current.key), key.text.data(), key.text.size()) == 0;
+		}
+
+		static std::size_t threshold_for(const std::size_t size)
+		{
+			return std::min(static_cast<std::size_t>(size * kMaxLoad), size - 1);
+		}
+
+		/**
+		 * Find the slot holding the key.
+		 * @return the slot, or the capacity when the key is missing.
+		 */
+		std::size_t find_position(const probe_key & key) const
+		{
+			if (this->capacity == 0)
+			{ // a moved from table has no slots.
+				return this->capacity;
+			} // else, there are slots to probe, do_nothing();
+			const auto mask = this->capacity - 1;
+			for (auto current_position = key.code & mask; this->slots[current_position].tag != kEmptyTag;
+				current_position = (current_position + 1) & mask)
+			{
+				if (this->slots[current_position].tag == key.tag && this->holds(this->slots[current_position], key))
+				{
+					return current_position;
+				} // else, a different key or a tombstone, do_nothing();
+			}
+			return this->capacity;
+		}
+
+		/**
+		 * Find the first empty slot of the probe sequence of a hash code, in an array without tombstones.
+		 */
+		std::size_t free_position(const std::size_t code) const
+		{
+			const auto mask = this->capacity - 1;
+			auto current_position = code & mask;
+			while (this->slots[current_position].tag != kEmptyTag)
+			{
+				current_position = (current_position + 1) & mask;
+			}
+			return current_position;
+		}
+
+		/**
+		 * Insert or replace the entry of the key.
+		 */
+		template <typename V>
+		bool insert_entry(V && value, const std::string_view text)
+		{
+			if (this->capacity == 0)
+			{ // a moved from table allocates again.
+				this->rehash_to(kMinCapacity);
+			}
+			else if (this->dead_bytes * 2 > this->arena.size() && this->dead_bytes > this->capacity)
+			{ // pack the arena, a key removed and inserted again takes back its tombstone and would never
+				// reach a rehash. The dead bytes must also outnumber the slots, so the rebuild stays amortized.
+				this->rehash_to(this->capacity);
+			} // else, the arena is mostly live, do_nothing();
+
+			const probe_key key(text, this->hasher(text));
+			const auto mask = this->capacity - 1;
+			auto current_position = key.code & mask;
+			auto free_position = this->capacity;
+			while (this->slots[current_position].tag != kEmptyTag)
+			{
+				if (this->slots[current_position].tag == key.tag && this->holds(this->slots[current_position], key))
+				{
+					this->values[current_position] = std::forward<V>(value);
+					return false;
+				}
+				else if (this->slots[current_position].tag == kDeletedTag && free_position == this->capacity)
+				{ // the first tombstone is reused, when the key turns out to be missing.
+					free_position = current_position;
+				} // else, a different key, do_nothing();
+				current_position = (current_position + 1) & mask;
+			}
+
+			slot placed{ key.tag, {} };
+			if (text.size() <= kInlineLength)
+			{
+				std::memcpy(placed.key, key.key, sizeof(placed.key));
+			}
+			else
+			{
+				if (text.size() >= 0x80000000u || this->arena.size() + text.size() > 0xFFFFFFFFu)
+				{
+					throw std::length_error("Key arena of a string_intern_table is full....");
+				} // else, the offset and length fit in 32 bits, do_nothing();
+				store32(placed.key, static_cast<std::uint32_t>(this->arena.size()));
+				store32(placed.key + 4, static_cast<std::uint32_t>(text.size()));
+			}
+
+			if (free_position == this->capacity && this->current_size + this->deleted_size + 1 > this->grow_threshold)
+			{ // grow unless the tombstones alone fill the table, then a rebuild of the same size drops them.
+				this->rehash_to(this->current_size + 1 > this->grow_threshold / 2 ? this->capacity * 2 : this->capacity);
+				if (!is_inline(placed))
+				{ // the rehash may have packed the arena, the key goes after the live bytes.
+					store32(placed.key, static_cast<std::uint32_t>(this->arena.size()));
+				} // else, the key is inline, do_nothing();
+				current_position = this->free_position(key.code);
+			}
+			else if (free_position != this->capacity)
+			{
+				current_position = free_position;
+			} // else, take the empty slot that ended the probe, do_nothing();
+
+			::new (static_cast<void *>(this->values + current_position)) T(std::forward<V>(value));
+			if (!is_inline(placed))
+			{
+				try
+				{
+					this->arena.insert(this->arena.end(), text.begin(), text.end());
+				}
+				catch (...)
+				{
+					this->values[current_position].~T();
+					throw;
+				}
+			} // else, the key is inline, do_nothing();
+
+			if (this->slots[current_position].tag == kDeletedTag)
+			{
+				--this->deleted_size;
+			} // else, an empty slot is taken, do_nothing();
+			this->slots[current_position] = placed;
+			++this->current_size;
+			return true;
+		}
+
+		/**
+		 * Rebuild the slots with the given number of slots, moving every value and
+		 * dropping the tombstones. The arena is packed as well once most of it is dead.
+		 */
+		void rehash_to(const std::size_t new_capacity)
+		{
+			auto old_slots = this->slots;
+			auto old_values = this->values;
+			const auto old_capacity = this->capacity;
+			const auto pack = this->dead_bytes * 2 > this->arena.size();
+			std::vector<char> packed;
+			if (pack)
+			{
+				packed.reserve(this->arena.size() - this->dead_bytes);
+			} // else, the arena is kept as it is, do_nothing();
+
+			this->allocate(new_capacity);
+			for (std::size_t i = 0; i < old_capacity; i++)
+			{
+				if (is_active(old_slots[i]))
+				{
+					auto moved = old_slots[i];
+					const auto key = this->key_of(moved);
+					if (pack && !is_inline(moved))
+					{
+						store32(moved.key, static_cast<std::uint32_t>(packed.size()));
+						packed.insert(packed.end(), key.begin(), key.end());
+					} // else, the key stays where it is, do_nothing();
+
+					const auto current_position = this->free_position(mix(this->hasher(key)));
+					this->slots[current_position] = moved;
+					::new (static_cast<void *>(this->values + current_position)) T(std::move(old_values[i]));
+					old_values[i].~T();
+				} // else, the slot holds no entry, do_nothing();
+			}
+
+			if (pack)
+			{
+				this->arena.swap(packed);
+				this->dead_bytes = 0;
+			} // else, the arena is kept as it is, do_nothing();
+			this->deleted_size = 0;
+			std::allocator<slot>().deallocate(old_slots, old_capacity);
+			std::allocator<T>().deallocate(old_values, old_capacity);
+		}
+
+		/**
+		 * Allocate empty slots and raw values for the capacity. The table is only
+		 * changed once both allocations succeed.
+		 */
+		void allocate(const std::size_t new_capacity)
+		{
+			auto new_slots = std::allocator<slot>().allocate(new_capacity);
+			T * new_values;
+			try
+			{
+				new_values = std::allocator<T>().allocate(new_capacity);
+			}
+			catch (...)
+			{
+				std::allocator<slot>().deallocate(new_slots, new_capacity);
+				throw;
+			}
+			for (std::size_t i = 0; i < new_capacity; i++)
+			{
+				new_slots[i] = slot{ kEmptyTag, {} };
+			}
+			this->slots = new_slots;
+			this->values = new_values;
+			this->capacity = new_capacity;
+			this->grow_threshold = threshold_for(new_capacity);
+		}
+
+		/**
+		 * Release the slots and values, the values must already be destroyed.
+		 */
+		void deallocate()
+		{
+			if (this->slots != nullptr)
+			{
+				std::allocator<slot>().deallocate(this->slots, this->capacity);
+				std::allocator<T>().deallocate(this->values, this->capacity);
+				this->slots = nullptr;
+				this->values = nullptr;
+			} // else, nothing was allocated, do_nothing();
+		}
+
+		/**
+		 * Destroy the value of every active slot.
+		 */
+		void destroy_values()
+		{
+			if (!std::is_trivially_destructible<T>::value)
+			{
+				for (std::size_t i = 0; i < this->capacity; i++)
+				{
+					if (is_active(this->slots[i]))
+					{
+						this->values[i].~T();
+					} // else, the slot holds no value, do_nothing();
+				}
+			} // else, there is nothing to destroy, do_nothing();
+		}
+
+		/**
+		 * Call the function on every entry of the table, see for_each_active.
+		 */
+		template <typename Table, typename Function>
+		static void visit(Table & table, Function & function)
+		{
+			for (std::size_t i = 0; i < table.capacity; i++)
+			{
+				if (is_active(table.slots[i]))
+				{
+					function(table.key_of(table.slots[i]), table.values[i]);
+				} // else, the slot holds no entry, do_nothing();
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,619 @@
+#ifndef SWISS_TABLE_H_
+#define SWISS_TABLE_H_
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "control_group.h"
+#include "hash_policy.h"
+
+namespace nwacc {
+
+	/**
+	 * Open addressing hash table of values T stored under keys K that keeps its
+	 * per slot state in a separate array of one byte control words.
+	 * A lookup compares 16 control bytes at a time against 7 bits of the hash
+	 * and only touches the entry storage of the slots whose tag matched, so a
+	 * probe over a large table costs one cache line of metadata per group.
+	 * Offers the key side of the hash_table interface.
+	 * @tparam Hash the function object hashing a key.
+	 * @tparam KeyEqual the function object comparing two keys for equality.
+	 */
+	template <typename T, typename K,
+		typename Hash = std::hash<K>,
+		typename KeyEqual = std::equal_to<K>>
+	class swiss_table
+	{
+	public:
+		/**
+		 * Create a new swiss_table able to hold the given number of slots
+		 * before growing, rounded up to whole groups.
+		 * @param size the number of slots to allocate.
+		 * @param hash the function object hashing a key.
+		 * @param equal the function object comparing two keys.
+		 */
+		explicit swiss_table(std::size_t size = control_group::kWidth,
+			const Hash & hash = Hash(), const KeyEqual & equal = KeyEqual())
+			: hasher(hash), key_equal(equal)
+		{
+			this->allocate(capacity_for(size));
+		}
+
+		swiss_table(const swiss_table & rhs)
+			: hasher(rhs.hasher), key_equal(rhs.key_equal)
+		{
+			this->allocate(rhs.capacity);
+			for (std::size_t i = 0; i < rhs.capacity; i++)
+			{
+				if (rhs.control[i] >= 0)
+				{
+					this->place(rhs.slots[i].element, rhs.slots[i].key);
+				} // else, the slot holds no entry, do_nothing();
+			}
+		}
+
+		/**
+		 * Move the entries of another swiss_table, which is left with no slots
+		 * and allocates a group again on its next insert.
+		 */
+		swiss_table(swiss_table && rhs) noexcept
+			: control(std::move(rhs.control)), slots(rhs.slots), capacity(rhs.capacity),
+			current_size(rhs.current_size), growth_left(rhs.growth_left),
+			hasher(std::move(rhs.hasher)), key_equal(std::move(rhs.key_equal))
+		{
+			rhs.slots = nullptr;
+			rhs.capacity = 0;
+			rhs.current_size = 0;
+			rhs.growth_left = 0;
+		}
+
+		swiss_table & operator=(swiss_table rhs) noexcept
+		{
+			this->swap(rhs);
+			return *this;
+		}
+
+		~swiss_table()
+		{
+			this->destroy_entries();
+			this->deallocate();
+		}
+
+		/**
+		 * Exchange the contents of two swiss_tables.
+		 */
+		void swap(swiss_table & rhs) noexcept
+		{
+			using std::swap;
+			swap(this->control, rhs.control);
+			swap(this->slots, rhs.slots);
+			swap(this->capacity, rhs.capacity);
+			swap(this->current_size, rhs.current_size);
+			swap(this->growth_left, rhs.growth_left);
+			swap(this->hasher, rhs.hasher);
+			swap(this->key_equal, rhs.key_equal);
+		}
+
+		/**
+		 * Determine if the swiss_table contains an entry with a matching key.
+		 */
+		bool contains(const K & key) const
+		{
+			return this->find_position(key) != this->capacity;
+		}
+
+		/**
+		 * Determine if the swiss_table contains an entry with a key equal to a value
+		 * of another type, without building a temporary key. Needs a transparent
+		 * Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		bool contains(const Q & key) const
+		{
+			return this->find_position(key) != this->capacity;
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		T * find(const K & key)
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Find the value stored under the key.
+		 * @param key the key being searched for.
+		 * @return a pointer to the value, or nullptr when the key is missing.
+		 */
+		const T * find(const K & key) const
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Find the value stored under a key equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		T * find(const Q & key)
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Find the value stored under a key equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		const T * find(const Q & key) const
+		{
+			return this->find_element(key);
+		}
+
+		/**
+		 * Remove every entry, keeping the allocated slots.
+		 */
+		void make_empty()
+		{
+			this->destroy_entries();
+			std::fill(this->control.begin(), this->control.end(), kControlEmpty);
+			this->current_size = 0;
+			this->growth_left = max_size_for(this->capacity);
+		}
+
+		/**
+		 * Insert the value under the key. If the key is already in the
+		 * swiss_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the swiss_table.
+		 */
+		bool insert(const T & value, const K & key)
+		{
+			return this->insert_entry(value, key);
+		}
+
+		/**
+		 * Insert the value under the key with move semantics. If the key is
+		 * already in the swiss_table its value is replaced.
+		 * @param value the data to be inserted.
+		 * @param key the key to be inserted.
+		 * @return true if a new entry was inserted.
+		 * @return false if the key was already in the swiss_table.
+		 */
+		bool insert(T && value, K && key)
+		{
+			return this->insert_entry(std::move(value), std::move(key));
+		}
+
+		/**
+		 * Removes the entry stored under the key.
+		 * @param key the key to remove.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the swiss_table.
+		 */
+		bool remove(const K & key)
+		{
+			return this->remove_key(key);
+		}
+
+		/**
+		 * Removes the entry whose key is equal to a value of another type.
+		 * Needs a transparent Hash and KeyEqual.
+		 * @param key the value compared against the keys.
+		 * @return true if an entry was removed.
+		 * @return false if the key is not in the swiss_table.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		bool remove(const Q & key)
+		{
+			return this->remove_key(key);
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the swiss_table throw a length error.
+		 */
+		T & get_key(const K & key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under the key.
+		 * If the key does not exist in the swiss_table throw a length error.
+		 */
+		const T & get_key(const K & key) const
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under a key equal to a value of another type.
+		 * If the key does not exist in the swiss_table throw a length error.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		T & get_key(const Q & key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under a key equal to a value of another type.
+		 * If the key does not exist in the swiss_table throw a length error.
+		 * Needs a transparent Hash and KeyEqual.
+		 */
+		template <typename Q, typename H = Hash, typename = enable_if_transparent<H, KeyEqual>>
+		const T & get_key(const Q & key) const
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				throw std::length_error("Key not found....");
+			} // else, key exists in the table do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * Returns the value stored under the key, inserting a default value
+		 * when the key is missing.
+		 */
+		T & operator[](const K & key)
+		{
+			auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				current_position = this->place(T{}, key);
+			} // else, the key is already in the swiss_table, do_nothing();
+			return this->slots[current_position].element;
+		}
+
+		/**
+		 * The number of entries in the swiss_table.
+		 */
+		std::size_t size() const
+		{
+			return this->current_size;
+		}
+
+	private:
+		/**
+		 * The storage of one slot, only constructed while its control byte is full.
+		 */
+		struct entry
+		{
+			T element;
+			K key;
+
+			template <typename V, typename Q>
+			entry(V && e, Q && k) : element(std::forward<V>(e)), key(std::forward<Q>(k)) { }
+		};
+
+		/**
+		 * Control bytes of every slot, kControlEmpty, kControlDeleted, or a 7 bit hash tag.
+		 */
+		std::vector<control_byte> control;
+
+		/**
+		 * Raw storage for the entries, parallel to the control bytes.
+		 */
+		entry * slots{};
+
+		/**
+		 * The number of slots, a power of two multiple of the group width.
+		 */
+		std::size_t capacity{};
+
+		/**
+		 * The number of active entries.
+		 */
+		std::size_t current_size{};
+
+		/**
+		 * The number of empty slots that can still be filled before the table grows.
+		 */
+		std::size_t growth_left{};
+
+		Hash hasher;
+
+		KeyEqual key_equal;
+
+		/**
+		 * Round a requested number of slots up to a valid capacity.
+		 */
+		static std::size_t capacity_for(const std::size_t size)
+		{
+			return power_of_two_policy::next_size(size < control_group::kWidth ? control_group::kWidth : size);
+		}
+
+		/**
+		 * The number of entries a capacity holds at the maximum load factor of 7/8.
+		 */
+		static std::size_t max_size_for(const std::size_t capacity)
+		{
+			return capacity - capacity / 8;
+		}
+
+		/**
+		 * The full hash of a key, mixed so the tag and the group index both get good bits.
+		 */
+		template <typename Q>
+		std::size_t hash(const Q & key) const
+		{
+			return mix(this->hasher(key));
+		}
+
+		/**
+		 * The 7 bit tag stored in the control byte of a full slot.
+		 */
+		static control_byte tag_of(const std::size_t hash)
+		{
+			return static_cast<control_byte>(hash & 0x7F);
+		}
+
+		/**
+		 * The first group probed for the hash.
+		 */
+		std::size_t home_group(const std::size_t hash) const
+		{
+			return (hash >> 7) & (this->capacity / control_group::kWidth - 1);
+		}
+
+		/**
+		 * Move to the next group of the triangular probe sequence.
+		 */
+		std::size_t next_group(const std::size_t group, std::size_t & off_set) const
+		{
+			return (group + off_set++) & (this->capacity / control_group::kWidth - 1);
+		}
+
+		/**
+		 * Find the slot holding the key.
+		 * @param key the key being searched for.
+		 * @return the slot of the key, or the capacity when it is missing.
+		 */
+		template <typename Q>
+		std::size_t find_position(const Q & key) const
+		{
+			if (this->capacity == 0)
+			{ // a moved from table has no groups to probe.
+				return this->capacity;
+			} // else, there is at least one group, do_nothing();
+			const auto hash = this->hash(key);
+			const auto tag = tag_of(hash);
+			std::size_t off_set = 1;
+			auto group = this->home_group(hash);
+
+			while (true)
+			{
+				const auto first = group * control_group::kWidth;
+				const control_group window(this->control.data() + first);
+				for (auto match = window.match(tag); match; match.next())
+				{
+					const auto current_position = first + match.lowest();
+					if (this->key_equal(this->slots[current_position].key, key))
+					{
+						return current_position;
+					} // else, the tags collided, do_nothing();
+				}
+
+				if (window.match_empty())
+				{ // a probe sequence never continues past a group with an empty slot.
+					return this->capacity;
+				} // else, the group is full, keep probing, do_nothing();
+				group = this->next_group(group, off_set);
+			}
+		}
+
+		/**
+		 * Find the first empty or deleted slot of the probe sequence of the hash.
+		 */
+		std::size_t find_free_position(const std::size_t hash) const
+		{
+			std::size_t off_set = 1;
+			auto group = this->home_group(hash);
+			while (true)
+			{
+				const auto first = group * control_group::kWidth;
+				const auto free = control_group(this->control.data() + first).match_empty_or_deleted();
+				if (free)
+				{
+					return first + free.lowest();
+				} // else, the group is full, keep probing, do_nothing();
+				group = this->next_group(group, off_set);
+			}
+		}
+
+		/**
+		 * The value stored under the key, or nullptr when it is missing.
+		 */
+		template <typename Q>
+		T * find_element(const Q & key) const
+		{
+			const auto current_position = this->find_position(key);
+			return current_position == this->capacity ? nullptr : &this->slots[current_position].element;
+		}
+
+		/**
+		 * Remove the entry stored under the key.
+		 * @param key the key, or a value comparable with the keys.
+		 * @return true if an entry was removed.
+		 */
+		template <typename Q>
+		bool remove_key(const Q & key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position == this->capacity)
+			{
+				return false;
+			}
+			else
+			{
+				this->erase_at(current_position);
+				return true;
+			}
+		}
+
+		/**
+		 * Insert or replace the entry of the key.
+		 */
+		template <typename V, typename Q>
+		bool insert_entry(V && value, Q && key)
+		{
+			const auto current_position = this->find_position(key);
+			if (current_position != this->capacity)
+			{
+				this->slots[current_position].element = std::forward<V>(value);
+				return false;
+			} // else, the key is new, do_nothing();
+
+			this->place(std::forward<V>(value), std::forward<Q>(key));
+			return true;
+		}
+
+		/**
+		 * Construct a new entry for a key known to be missing, growing the table first if needed.
+		 * @return the slot the entry was placed in.
+		 */
+		template <typename V, typename Q>
+		std::size_t place(V && value, Q && key)
+		{
+			if (this->capacity == 0)
+			{ // a moved from table allocates a group again.
+				this->deallocate();
+				this->allocate(control_group::kWidth);
+			} // else, the slots are allocated, do_nothing();
+			auto hash = this->hash(key);
+			auto current_position = this->find_free_position(hash);
+			if (this->growth_left == 0 && this->control[current_position] == kControlEmpty)
+			{
+				this->rehash();
+				current_position = this->find_free_position(hash);
+			} // else, there is room for the entry, do_nothing();
+
+			::new (static_cast<void *>(this->slots + current_position)) entry(std::forward<V>(value), std::forward<Q>(key));
+			if (this->control[current_position] == kControlEmpty)
+			{
+				--this->growth_left;
+			} // else, a deleted slot is reused, do_nothing();
+			this->control[current_position] = tag_of(hash);
+			++this->current_size;
+			return current_position;
+		}
+
+		/**
+		 * Destroy the entry of a slot and release its control byte.
+		 */
+		void erase_at(const std::size_t current_position)
+		{
+			this->slots[current_position].~entry();
+			--this->current_size;
+
+			const auto first = current_position & ~(control_group::kWidth - 1);
+			if (control_group(this->control.data() + first).match_empty())
+			{ // no probe sequence continues past this group, so the slot can go back to empty.
+				this->control[current_position] = kControlEmpty;
+				++this->growth_left;
+			}
+			else
+			{
+				this->control[current_position] = kControlDeleted;
+			}
+		}
+
+		/**
+		 * Grow the table, or rebuild it at the same size when most of the
+		 * used slots are deleted ones, moving every entry to its new slot.
+		 */
+		void rehash()
+		{
+			const auto new_capacity = this->current_size * 2 < max_size_for(this->capacity)
+				? this->capacity
+				: this->capacity * 2;
+
+			auto old_control = std::move(this->control);
+			auto old_slots = this->slots;
+			const auto old_capacity = this->capacity;
+			this->allocate(new_capacity);
+
+			for (std::size_t i = 0; i < old_capacity; i++)
+			{
+				if (old_control[i] >= 0)
+				{
+					auto & old_entry = old_slots[i];
+					const auto hash = this->hash(old_entry.key);
+					const auto current_position = this->find_free_position(hash);
+					::new (static_cast<void *>(this->slots + current_position))
+						entry(std::move(old_entry.element), std::move(old_entry.key));
+					this->control[current_position] = tag_of(hash);
+					old_entry.~entry();
+				} // else, the slot holds no entry, do_nothing();
+			}
+			this->growth_left -= this->current_size;
+			std::allocator<entry>().deallocate(old_slots, old_capacity);
+		}
+
+		/**
+		 * Allocate empty control bytes and raw slots for the capacity.
+		 */
+		void allocate(const std::size_t new_capacity)
+		{
+			this->control.assign(new_capacity, kControlEmpty);
+			this->slots = std::allocator<entry>().allocate(new_capacity);
+			this->capacity = new_capacity;
+			this->growth_left = max_size_for(new_capacity);
+		}
+
+		/**
+		 * Release the raw slots, the entries must already be destroyed.
+		 */
+		void deallocate()
+		{
+			if (this->slots != nullptr)
+			{
+				std::allocator<entry>().deallocate(this->slots, this->capacity);
+				this->slots = nullptr;
+			} // else, nothing was allocated, do_nothing();
+		}
+
+		/**
+		 * Destroy every active entry.
+		 */
+		void destroy_entries()
+		{
+			for (std::size_t i = 0; i < this->capacity; i++)
+			{
+				if (this->control[i] >= 0)
+				{
+					this->slots[i].~entry();
+				} // else, the slot holds no entry, do_nothing();
+			}
+		}
+	};
+}
+
+#endif